@@ -0,0 +1,124 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+
+
+/**
+ * Cached list of the components of a type owned by an actor
+ * 
+ * Tips:
+ *	GFC components add and remove themselves in OnRegister and OnUnregister, so the list stays current when components are replaced.
+ *	Other components of the type are picked up by rebuilding the list when the number of components owned by the actor changes 
+ *	or a cached component has been destroyed, so forwarding events to the components neither allocates nor walks all components of the actor.
+ */
+template<typename ComponentType>
+class TGFCComponentRegistry
+{
+public:
+	TGFCComponentRegistry() {}
+
+protected:
+	//
+	// Cached components
+	//
+	TArray<TWeakObjectPtr<ComponentType>, TInlineAllocator<8>> Components;
+
+	//
+	// Number of components owned by the actor when the list was built
+	//
+	int32 NumOwnedComponents{ INDEX_NONE };
+
+public:
+	/**
+	 * Rebuild the list the next time it is used
+	 */
+	void Invalidate() { NumOwnedComponents = INDEX_NONE; }
+
+	/**
+	 * Add the component to the list (called from OnRegister of the component)
+	 */
+	void Register(ComponentType* Component)
+	{
+		// Not built yet, the component will be found when the list is built
+
+		if (NumOwnedComponents != INDEX_NONE)
+		{
+			Components.AddUnique(Component);
+		}
+	}
+
+	/**
+	 * Remove the component from the list (called from OnUnregister of the component)
+	 */
+	void Unregister(ComponentType* Component)
+	{
+		Components.Remove(Component);
+	}
+
+	/**
+	 * Execute the function for each cached component of the actor
+	 */
+	template<typename FuncType>
+	void ForEach(const AActor* Owner, FuncType&& Func)
+	{
+		Refresh(Owner);
+
+		// Rebuild before dispatching if a component was destroyed without unregistering,
+		// so that one-shot events are not skipped for the components that replaced it
+
+		const auto bHasStaleComponent
+		{
+			Components.ContainsByPredicate(
+				[](const TWeakObjectPtr<ComponentType>& Component)
+				{
+					return !Component.IsValid();
+				}
+			)
+		};
+
+		if (bHasStaleComponent)
+		{
+			Invalidate();
+			Refresh(Owner);
+		}
+
+		// Iterate over a copy since the function may add or remove components
+
+		const TArray<TWeakObjectPtr<ComponentType>, TInlineAllocator<8>> CurrentComponents{ Components };
+
+		for (const auto& Component : CurrentComponents)
+		{
+			if (auto* StrongComponent{ Component.Get() })
+			{
+				Func(StrongComponent);
+			}
+		}
+	}
+
+protected:
+	void Refresh(const AActor* Owner)
+	{
+		check(Owner);
+
+		const auto NewNumOwnedComponents{ Owner->GetComponents().Num() };
+
+		if (NewNumOwnedComponents == NumOwnedComponents)
+		{
+			return;
+		}
+
+		NumOwnedComponents = NewNumOwnedComponents;
+
+		Components.Reset();
+
+		Owner->ForEachComponent<ComponentType>(false,
+			[this](ComponentType* Component)
+			{
+				Components.Add(Component);
+			}
+		);
+	}
+
+};
@@ -4,6 +4,10 @@
 
 #include "InitState/InitStateTags.h"
 #include "InitState/InitStateComponent.h"
+#include "InitState/InitStateSubsystem.h"
+#include "InitState/InitStateDependencyGraph.h"
+#include "InitState/InitStateTransitionTable.h"
+#include "GameMode/GFCGameState.h"
 #include "GFCoreLogs.h"
 
 #include "Components/GameFrameworkComponentManager.h"
@@ -35,16 +39,46 @@ void UGFCGameStateComponent::OnRegister()
 	// Register this component in the GameFrameworkComponentManager.
 
 	RegisterInitStateFeature();
+
+	// Declare the features this feature depends on in the dependency graph of the actor class
+
+	FInitStateDependencyGraph::DeclareFeature(GetOwner(), GetFeatureName(),
+		[this](TArray<FInitStateFeatureDependency>& OutDependencies)
+		{
+			GetInitStateDependencies(OutDependencies);
+		}
+	);
+
+	// Keep the component list of the game state current for the events forwarded to the components
+
+	if (auto* GFCOwner{ GetGameState<AGFCGameState>() })
+	{
+		GFCOwner->GameStateComponents.Register(this);
+	}
+}
+
+void UGFCGameStateComponent::OnUnregister()
+{
+	if (auto* GFCOwner{ GetGameState<AGFCGameState>() })
+	{
+		GFCOwner->GameStateComponents.Unregister(this);
+	}
+
+	Super::OnUnregister();
 }
 
 void UGFCGameStateComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// Start listening for changes in the initialization state of all features 
+	// Get woken up when the declared dependencies are satisfied.
+	// If the world has no scheduler, start listening for changes in the initialization state of all features 
 	// related to the Pawn that owns this component.
 
-	BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
+	if (!UInitStateSubsystem::RegisterFeature(this, GetFeatureName()))
+	{
+		BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
+	}
 
 	// Change the initialization state of this component to [Spawned]
 
@@ -52,11 +86,13 @@ void UGFCGameStateComponent::BeginPlay()
 
 	// Check if initialization process can continue
 
-	CheckDefaultInitialization();
+	UInitStateSubsystem::RequestCheckDefaultInitialization(this);
 }
 
 void UGFCGameStateComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	UInitStateSubsystem::UnregisterFeature(this, GetFeatureName());
+
 	UnregisterInitStateFeature();
 
 	Super::EndPlay(EndPlayReason);
@@ -67,49 +103,42 @@ bool UGFCGameStateComponent::CanChangeInitState(UGameFrameworkComponentManager*
 {
 	check(Manager);
 
-	/**
-	 * [InitState None] -> [InitState Spawned]
-	 */
-	if (!CurrentState.IsValid() && DesiredState == TAG_InitState_Spawned)
+	// Only the transition to the next state of the chain is allowed
+
+	const auto& Table{ FInitStateTransitionTable::Get() };
+	const auto StateIndex{ Table.FindTransition(CurrentState, DesiredState) };
+
+	if (StateIndex == INDEX_NONE)
 	{
-		if (GetOwner() == nullptr)
-		{
-			return false;
-		}
+		return false;
+	}
 
-		return CanChangeInitStateToSpawned(Manager);
+	// Features declared as dependencies must have reached the required states
+
+	const auto* Owner{ GetOwner() };
+
+	if (!Owner || !FInitStateDependencyGraph::Get(Owner->GetClass()).AreDependenciesMet(Manager, GetOwner(), GetFeatureName(), DesiredState))
+	{
+		return false;
 	}
 
-	/**
-	 * [InitState Spawned] -> [InitState DataAvailable]
-	 */
-	else if (CurrentState == TAG_InitState_Spawned && DesiredState == TAG_InitState_DataAvailable)
+	switch (Table.GetBuiltinState(StateIndex))
 	{
-		if (!Manager->HasFeatureReachedInitState(GetOwner(), UInitStateComponent::NAME_ActorFeatureName, TAG_InitState_DataAvailable))
-		{
-			return false;
-		}
+	case EInitStateBuiltin::Spawned:
+		return CanChangeInitStateToSpawned(Manager);
 
+	case EInitStateBuiltin::DataAvailable:
 		return CanChangeInitStateToDataAvailable(Manager);
-	}
 
-	/**
-	 * [InitState DataAvailable] -> [InitState DataInitialized]
-	 */
-	else if (CurrentState == TAG_InitState_DataAvailable && DesiredState == TAG_InitState_DataInitialized)
-	{
+	case EInitStateBuiltin::DataInitialized:
 		return CanChangeInitStateToDataInitialized(Manager);
-	}
 
-	/**
-	 * [InitState DataInitialized] -> [InitState GameplayReady]
-	 */
-	else if (CurrentState == TAG_InitState_DataInitialized && DesiredState == TAG_InitState_GameplayReady)
-	{
+	case EInitStateBuiltin::GameplayReady:
 		return CanChangeInitStateToGameplayReady(Manager);
-	}
 
-	return false;
+	default:
+		return CanChangeInitStateToCustom(Manager, DesiredState);
+	}
 }
 
 void UGFCGameStateComponent::HandleChangeInitState(UGameFrameworkComponentManager* Manager, FGameplayTag CurrentState, FGameplayTag DesiredState)
@@ -121,59 +150,86 @@ void UGFCGameStateComponent::HandleChangeInitState(UGameFrameworkComponentManage
 		*GetNameSafe(this),
 		*DesiredState.GetTagName().ToString());
 
-	/**
-	 * [InitState None] -> [InitState Spawned]
-	 */
-	if (!CurrentState.IsValid() && DesiredState == TAG_InitState_Spawned)
+	const auto& Table{ FInitStateTransitionTable::Get() };
+
+	switch (Table.GetBuiltinState(Table.GetStateIndex(DesiredState)))
 	{
+	case EInitStateBuiltin::Spawned:
 		HandleChangeInitStateToSpawned(Manager);
-	}
+		break;
 
-	/**
-	 * [InitState Spawned] -> [InitState DataAvailable]
-	 */
-	else if (CurrentState == TAG_InitState_Spawned && DesiredState == TAG_InitState_DataAvailable)
-	{
+	case EInitStateBuiltin::DataAvailable:
 		HandleChangeInitStateToDataAvailable(Manager);
-	}
+		break;
 
-	/**
-	 * [InitState DataAvailable] -> [InitState DataInitialized]
-	 */
-	else if (CurrentState == TAG_InitState_DataAvailable && DesiredState == TAG_InitState_DataInitialized)
-	{
+	case EInitStateBuiltin::DataInitialized:
 		HandleChangeInitStateToDataInitialized(Manager);
-	}
+		break;
 
-	/**
-	 * [InitState DataInitialized] -> [InitState GameplayReady]
-	 */
-	else if (CurrentState == TAG_InitState_DataInitialized && DesiredState == TAG_InitState_GameplayReady)
-	{
+	case EInitStateBuiltin::GameplayReady:
 		HandleChangeInitStateToGameplayReady(Manager);
+		break;
+
+	default:
+		HandleChangeInitStateToCustom(Manager, DesiredState);
+		break;
 	}
 }
 
 void UGFCGameStateComponent::OnActorInitStateChanged(const FActorInitStateChangedParams& Params)
 {
-	if (Params.FeatureName == UInitStateComponent::NAME_ActorFeatureName)
+	// Only wake up when the change satisfied the declared dependencies
+
+	if (UInitStateSubsystem::ShouldWakeFeature(this, GetFeatureName(), Params))
 	{
-		if (Params.FeatureState == TAG_InitState_DataAvailable)
-		{
-			CheckDefaultInitialization();
-		}
+		UInitStateSubsystem::RequestCheckDefaultInitialization(this);
 	}
 }
 
-void UGFCGameStateComponent::CheckDefaultInitialization()
+void UGFCGameStateComponent::GetInitStateDependencies(TArray<FInitStateFeatureDependency>& OutDependencies) const
 {
-	static const TArray<FGameplayTag> StateChain
+	/**
+	 * [InitState DataAvailable] requires the InitState feature to be [InitState DataAvailable]
+	 */
+	OutDependencies.Emplace(TAG_InitState_DataAvailable, UInitStateComponent::NAME_ActorFeatureName, TAG_InitState_DataAvailable);
+}
+
+void UGFCGameStateComponent::OnReleasedToPool()
+{
+	// Rewind the init state of this feature without re-creating the component
+
+	UInitStateSubsystem::UnregisterFeature(this, GetFeatureName());
+
+	UnregisterInitStateFeature();
+	RegisterInitStateFeature();
+}
+
+void UGFCGameStateComponent::OnReacquiredFromPool(EInitStatePoolReacquireMode Mode)
+{
+	// Rebind the listener that was removed with the feature registration
+
+	if (!UInitStateSubsystem::RegisterFeature(this, GetFeatureName()))
+	{
+		BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
+	}
+
+	// Change the initialization state of this component to [Spawned]
+
+	ensureMsgf(TryToChangeInitState(TAG_InitState_Spawned), TEXT("[%s] on [%s]."), *GetNameSafe(this), *GetNameSafe(GetOwner()));
+
+	// Skip the data gathering if the data of the previous use is still valid
+
+	if (Mode == EInitStatePoolReacquireMode::RestoreDataInitialized)
 	{
-		TAG_InitState_Spawned,
-		TAG_InitState_DataAvailable,
-		TAG_InitState_DataInitialized,
-		TAG_InitState_GameplayReady
-	};
+		UInitStateSubsystem::FastForwardFeature(this, GetFeatureName(), TAG_InitState_DataInitialized);
+	}
 
-	ContinueInitStateChain(StateChain);
+	// Check if initialization process can continue
+
+	UInitStateSubsystem::RequestCheckDefaultInitialization(this);
+}
+
+void UGFCGameStateComponent::CheckDefaultInitialization()
+{
+	ContinueInitStateChain(FInitStateTransitionTable::Get().GetStateChain());
 }
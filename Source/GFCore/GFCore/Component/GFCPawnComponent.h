@@ -4,6 +4,8 @@
 
 #include "Components/PawnComponent.h"
 #include "Components/GameFrameworkInitStateInterface.h"
+#include "InitState/InitStateDependencyGraph.h"
+#include "InitState/InitStatePoolableInterface.h"
 
 #include "GFCPawnComponent.generated.h"
 
@@ -15,6 +17,7 @@ UCLASS()
 class GFCORE_API UGFCPawnComponent 
 	: public UPawnComponent
 	, public IGameFrameworkInitStateInterface
+	, public IInitStatePoolableInterface
 {
 	GENERATED_BODY()
 public:
@@ -31,15 +34,29 @@ public:
 	virtual void OnActorInitStateChanged(const FActorInitStateChangedParams& Params) override;
 	virtual void CheckDefaultInitialization() override;
 
+	/**
+	 * Collect the features and states this feature depends on
+	 * 
+	 * Tips:
+	 *	Called once per actor class, override and call Super to add dependencies.
+	 */
+	virtual void GetInitStateDependencies(TArray<FInitStateFeatureDependency>& OutDependencies) const;
+
+public:
+	virtual void OnReleasedToPool() override;
+	virtual void OnReacquiredFromPool(EInitStatePoolReacquireMode Mode) override;
+
 protected:
 	virtual bool CanChangeInitStateToSpawned(UGameFrameworkComponentManager* Manager) const { return true; }
 	virtual bool CanChangeInitStateToDataAvailable(UGameFrameworkComponentManager* Manager) const { return true; }
 	virtual bool CanChangeInitStateToDataInitialized(UGameFrameworkComponentManager* Manager) const { return true; }
 	virtual bool CanChangeInitStateToGameplayReady(UGameFrameworkComponentManager* Manager) const { return true; }
+	virtual bool CanChangeInitStateToCustom(UGameFrameworkComponentManager* Manager, FGameplayTag DesiredState) const { return true; }
 
 	virtual void HandleChangeInitStateToSpawned(UGameFrameworkComponentManager* Manager) {}
 	virtual void HandleChangeInitStateToDataAvailable(UGameFrameworkComponentManager* Manager) {}
 	virtual void HandleChangeInitStateToDataInitialized(UGameFrameworkComponentManager* Manager) {}
 	virtual void HandleChangeInitStateToGameplayReady(UGameFrameworkComponentManager* Manager) {}
+	virtual void HandleChangeInitStateToCustom(UGameFrameworkComponentManager* Manager, FGameplayTag DesiredState) {}
 
 };
@@ -4,6 +4,8 @@
 
 #include "Components/PlayerStateComponent.h"
 #include "Components/GameFrameworkInitStateInterface.h"
+#include "InitState/InitStateDependencyGraph.h"
+#include "InitState/InitStatePoolableInterface.h"
 
 #include "GFCPlayerStateComponent.generated.h"
 
@@ -16,6 +18,7 @@ UCLASS()
 class GFCORE_API UGFCPlayerStateComponent
 	: public UPlayerStateComponent
 	, public IGameFrameworkInitStateInterface
+	, public IInitStatePoolableInterface
 {
 	GENERATED_BODY()
 public:
@@ -23,6 +26,7 @@ public:
 
 protected:
 	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
@@ -32,15 +36,39 @@ public:
 	virtual void OnActorInitStateChanged(const FActorInitStateChangedParams& Params) override;
 	virtual void CheckDefaultInitialization() override;
 
+	/**
+	 * Collect the features and states this feature depends on
+	 * 
+	 * Tips:
+	 *	Called once per actor class, override and call Super to add dependencies.
+	 */
+	virtual void GetInitStateDependencies(TArray<FInitStateFeatureDependency>& OutDependencies) const;
+
+public:
+	virtual void OnReleasedToPool() override;
+	virtual void OnReacquiredFromPool(EInitStatePoolReacquireMode Mode) override;
+
+public:
+	/**
+	 * Transfer the properties to the component of the new player state on seamless travel
+	 * 
+	 * Tips:
+	 *	Called instead of CopyProperties if bMovePlayerStateComponentProperties is enabled in UGameFrameworkDeveloperSettings.
+	 *	This component is destroyed after the transfer, so its properties can be moved instead of copied.
+	 */
+	virtual void MoveProperties(UPlayerStateComponent* TargetPlayerStateComponent) { CopyProperties(TargetPlayerStateComponent); }
+
 protected:
 	virtual bool CanChangeInitStateToSpawned(UGameFrameworkComponentManager* Manager) const { return true; }
 	virtual bool CanChangeInitStateToDataAvailable(UGameFrameworkComponentManager* Manager) const { return true; }
 	virtual bool CanChangeInitStateToDataInitialized(UGameFrameworkComponentManager* Manager) const { return true; }
 	virtual bool CanChangeInitStateToGameplayReady(UGameFrameworkComponentManager* Manager) const { return true; }
+	virtual bool CanChangeInitStateToCustom(UGameFrameworkComponentManager* Manager, FGameplayTag DesiredState) const { return true; }
 
 	virtual void HandleChangeInitStateToSpawned(UGameFrameworkComponentManager* Manager) {}
 	virtual void HandleChangeInitStateToDataAvailable(UGameFrameworkComponentManager* Manager) {}
 	virtual void HandleChangeInitStateToDataInitialized(UGameFrameworkComponentManager* Manager) {}
 	virtual void HandleChangeInitStateToGameplayReady(UGameFrameworkComponentManager* Manager) {}
+	virtual void HandleChangeInitStateToCustom(UGameFrameworkComponentManager* Manager, FGameplayTag DesiredState) {}
 
 };
@@ -10,3 +10,34 @@ UGameFrameworkDeveloperSettings::UGameFrameworkDeveloperSettings()
 	CategoryName = TEXT("Game XXX Core");
 	SectionName = TEXT("Game Framework Core");
 }
+
+#if WITH_EDITOR
+void UGameFrameworkDeveloperSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(ThisClass, TagStackReplicationPolicies))
+	{
+		++TagStackReplicationPoliciesRevision;
+	}
+}
+#endif
+
+
+EGameplayTagStackReplicationPolicy UGameFrameworkDeveloperSettings::GetTagStackReplicationPolicy(FGameplayTag Tag) const
+{
+	if (TagStackReplicationPolicies.IsEmpty())
+	{
+		return EGameplayTagStackReplicationPolicy::All;
+	}
+
+	for (auto CurrentTag{ Tag }; CurrentTag.IsValid(); CurrentTag = CurrentTag.RequestDirectParent())
+	{
+		if (const auto* Policy{ TagStackReplicationPolicies.Find(CurrentTag) })
+		{
+			return *Policy;
+		}
+	}
+
+	return EGameplayTagStackReplicationPolicy::All;
+}
@@ -3,6 +3,9 @@
 #pragma once
 
 #include "Engine/DeveloperSettings.h"
+#include "Engine/EngineBaseTypes.h"
+#include "GameplayTagContainer.h"
+#include "GameplayTag/GameplayTagStackReplicationPolicy.h"
 
 #include "GameFrameworkDeveloperSettings.generated.h"
 
@@ -18,6 +21,10 @@ public:
 public:
 	UGameFrameworkDeveloperSettings();
 
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	///////////////////////////////////////////////
 	// Game Features
 public:
@@ -27,5 +34,99 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = "Game Features", meta = (MustImplement = "/Script/GameFeatures.GameFeatureStateChangeObserver"))
 	TArray<FSoftClassPath> Observers;
 
+	///////////////////////////////////////////////
+	// Messaging
+public:
+	//
+	// Tick group in which messages queued for listeners with Queued delivery are flushed
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Messaging")
+	TEnumAsByte<ETickingGroup> QueuedMessageTickGroup{ TG_PostUpdateWork };
+
+	//
+	// Maximum number of messages broadcast from other threads waiting to be delivered on the game thread (0 for unlimited)
+	// 
+	// Tips:
+	//	Messages broadcast beyond this limit are dropped with a warning.
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Messaging", meta = (ClampMin = 0))
+	int32 MaxThreadSafeMessages{ 4096 };
+
+	///////////////////////////////////////////////
+	// Init State
+public:
+	//
+	// Whether the init state checks requested by features are evaluated once per frame instead of immediately
+	// 
+	// Tips:
+	//	When enabled, chains that would otherwise complete synchronously in BeginPlay complete on a later tick.
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Init State")
+	bool bDeferInitStateEvaluation{ false };
+
+	//
+	// States of the init state chain in the order they are reached (the built-in chain is used if empty)
+	// 
+	// Tips:
+	//	Must start with InitState.Spawned and keep the other built-in states in order, 
+	//	custom states such as InitState.AssetsStreamed can be inserted between them.
+	//	Changes are applied when the next game instance is initialized, since the states are registered at that time.
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Init State", meta = (Categories = "InitState"))
+	TArray<FGameplayTag> InitStateChain;
+
+	//
+	// Seconds an actor may take to reach the last state of the init state chain before it is reported with its blocking features (0 to disable)
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Init State", meta = (ClampMin = 0, Units = "s"))
+	float InitStateWatchdogBudget{ 10.0f };
+
+	///////////////////////////////////////////////
+	// Player Tick
+public:
+	//
+	// Whether the PlayerTick of controller components is ticked by UPlayerTickBatchSubsystem, one class at a time for all players
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Player Tick")
+	bool bBatchControllerPlayerTick{ false };
+
+	//
+	// Whether batched controller components implementing IParallelPlayerTickInterface are ticked in parallel
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Player Tick", meta = (EditCondition = "bBatchControllerPlayerTick"))
+	bool bAllowParallelPlayerTick{ false };
+
+	///////////////////////////////////////////////
+	// Player State
+public:
+	//
+	// Whether GFC player state components transfer their properties with MoveProperties instead of CopyProperties on seamless travel
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Player State")
+	bool bMovePlayerStateComponentProperties{ false };
+
+	///////////////////////////////////////////////
+	// Tag Stack
+public:
+	//
+	// Replication policy of tag stacks by tag prefix (the closest parent tag in the list is used)
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Tag Stack")
+	TMap<FGameplayTag, EGameplayTagStackReplicationPolicy> TagStackReplicationPolicies;
+
+protected:
+	//
+	// Incremented each time TagStackReplicationPolicies is edited, so that containers can discard their cached policies
+	//
+	uint32 TagStackReplicationPoliciesRevision{ 0 };
+
+public:
+	/**
+	 * Returns the replication policy of the tag stack with the specified tag
+	 */
+	EGameplayTagStackReplicationPolicy GetTagStackReplicationPolicy(FGameplayTag Tag) const;
+
+	uint32 GetTagStackReplicationPoliciesRevision() const { return TagStackReplicationPoliciesRevision; }
+
 };
 
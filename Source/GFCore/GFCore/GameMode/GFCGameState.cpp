@@ -74,12 +74,12 @@ void AGFCGameState::HandleMatchHasStarted()
 {
 	Super::HandleMatchHasStarted();
 
-	TArray<UGameStateComponent*> GFCComponents;
-	GetComponents(GFCComponents);
-	for (const auto& Component : GFCComponents)
-	{
-		Component->HandleMatchHasStarted();
-	}
+	GameStateComponents.ForEach(this,
+		[](UGameStateComponent* Component)
+		{
+			Component->HandleMatchHasStarted();
+		}
+	);
 }
 
 #pragma endregion
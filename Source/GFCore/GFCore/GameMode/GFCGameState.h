@@ -4,8 +4,12 @@
 
 #include "GameFramework/GameState.h"
 
+#include "Component/GFCComponentRegistry.h"
+
 #include "GFCGameState.generated.h"
 
+class UGameStateComponent;
+
 
 /** 
  * Pair this with a GFCGameModeBase 
@@ -43,4 +47,12 @@ public:
 protected:
 	virtual void HandleMatchHasStarted() override;
 
+protected:
+	//
+	// Game state components notified of the match events
+	//
+	TGFCComponentRegistry<UGameStateComponent> GameStateComponents;
+
+	friend class UGFCGameStateComponent;
+
 };
@@ -2,9 +2,13 @@
 
 #include "GameplayTagStack.h"
 
-#include "Message/GameplayMessageSubsystem.h"
+#include "GameplayTag/GameplayTagStackOps.h"
 #include "GameplayTag/GameplayTagStackMessageTypes.h"
-#include "GFCoreLogs.h"
+
+#include "GameplayTagsManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/BitWriter.h"
+#include "Engine/NetSerialization.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GameplayTagStack)
 
@@ -14,39 +18,43 @@
 
 #pragma region FGameplayTagStack
 
-bool FGameplayTagStack::Match(const FGameplayTag OtherTag) const
+FString FGameplayTagStack::GetDebugString() const
 {
-	return Tag == OtherTag;
+	return FString::Printf(TEXT("%s(%d/%d)"), *Tag.ToString(), StackCount, MaxStackCount);
 }
 
-bool FGameplayTagStack::WillBeZero(int32 NumToRemove) const
+bool FGameplayTagStack::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
-	return StackCount <= NumToRemove;
-}
+	bOutSuccess = true;
 
+	auto bTagSuccess{ true };
+	Tag.NetSerialize(Ar, Map, bTagSuccess);
 
-int32 FGameplayTagStack::AddStackValue(int32 NumToAdd)
-{
-	return ChangeStackValue(StackCount + NumToAdd);
-}
+	// Stack count is zig-zag encoded so that small values take one byte regardless of sign
 
-int32 FGameplayTagStack::ChangeStackValue(int32 NewCount)
-{
-	StackCount = (MaxStackCount != -1) ? FMath::Clamp(NewCount, 0, MaxStackCount) : FMath::Max(NewCount, 0);
-	return StackCount;
-}
+	auto EncodedStackCount{ (uint32(StackCount) << 1) ^ uint32(StackCount >> 31) };
+	Ar.SerializeIntPacked(EncodedStackCount);
 
-int32 FGameplayTagStack::ChangeMaxStackValue(int32 NewCount)
-{
-	MaxStackCount = (NewCount <= 0) ? -1 : NewCount;
+	// Max stack count is only written when it is set (-1 is the common case)
 
-	return ChangeStackValue(StackCount);
-}
+	uint8 bHasMaxStackCount{ (MaxStackCount != -1) ? uint8(1) : uint8(0) };
+	Ar.SerializeBits(&bHasMaxStackCount, 1);
 
+	auto EncodedMaxStackCount{ bHasMaxStackCount ? uint32(MaxStackCount) : uint32(0) };
+	if (bHasMaxStackCount)
+	{
+		Ar.SerializeIntPacked(EncodedMaxStackCount);
+	}
 
-FString FGameplayTagStack::GetDebugString() const
-{
-	return FString::Printf(TEXT("%s(%d/%d)"), *Tag.ToString(), StackCount, MaxStackCount);
+	if (Ar.IsLoading())
+	{
+		StackCount = int32(EncodedStackCount >> 1) ^ -int32(EncodedStackCount & 1);
+		MaxStackCount = bHasMaxStackCount ? int32(EncodedMaxStackCount) : -1;
+	}
+
+	bOutSuccess = bTagSuccess && !Ar.IsError();
+
+	return true;
 }
 
 #pragma endregion
@@ -57,288 +65,284 @@ FString FGameplayTagStack::GetDebugString() const
 
 #pragma region FGameplayTagStackContainer
 
-void FGameplayTagStackContainer::PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize)
+void FGameplayTagStackContainer::SetLookupMode(EGameplayTagStackLookupMode NewLookupMode)
 {
-	for (const auto& Index : RemovedIndices)
-	{
-		const auto Tag{ Stacks[Index].Tag };
+	FOps::SetLookupMode(*this, NewLookupMode);
+}
 
-		RefreshFastStacks(EStackChangeType::Remove, Tag);
-	}
+void FGameplayTagStackContainer::SetTrackParentAggregates(bool bEnabled)
+{
+	FOps::SetTrackParentAggregates(*this, bEnabled);
 }
 
-void FGameplayTagStackContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
+void FGameplayTagStackContainer::SetPublishSnapshots(bool bEnabled)
 {
-	for (const auto& Index : AddedIndices)
-	{
-		const auto& Stack{ Stacks[Index] };
+	FOps::SetPublishSnapshots(*this, bEnabled);
+}
 
-		RefreshFastStacks(EStackChangeType::AddOrChange, Stack.Tag, Stack);
-	}
+
+void FGameplayTagStackContainer::PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize)
+{
+	FOps::PreReplicatedRemove(*this, RemovedIndices);
+}
+
+void FGameplayTagStackContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
+{
+	FOps::PostReplicatedAddOrChange(*this, AddedIndices);
 }
 
 void FGameplayTagStackContainer::PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize)
 {
-	for (const auto& Index : ChangedIndices)
-	{
-		const auto& Stack{ Stacks[Index] };
+	FOps::PostReplicatedAddOrChange(*this, ChangedIndices);
+}
 
-		RefreshFastStacks(EStackChangeType::AddOrChange, Stack.Tag, Stack);
-	}
+bool FGameplayTagStackContainer::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	return FOps::NetDeltaSerialize(*this, DeltaParms);
 }
 
 
-void FGameplayTagStackContainer::RefreshFastStacks(EStackChangeType ChangeType, const FGameplayTag& Tag, FFastGameplayTagStack Stack)
+FGameplayMessageListenerHandle FGameplayTagStackContainer::RegisterStackChangeListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagStackCountChangeMessage&)>&& Callback) const
 {
-	switch (ChangeType)
-	{
-	case FGameplayTagStackContainer::EStackChangeType::AddOrChange:
-		FastStacks.Emplace(Tag, Stack);
-		break;
+	return FOps::RegisterListener(*this, Tag, MoveTemp(Callback));
+}
 
-	case FGameplayTagStackContainer::EStackChangeType::Remove:
-		FastStacks.Remove(Tag);
-		break;
-	}
-	
-	BroadcastTagStackChangeMessage(Tag, Stack.StackCount, Stack.MaxStackCount);
+FGameplayTag FGameplayTagStackContainer::GetMessageChannel()
+{
+	return TAG_Message_TagStackCountChange;
 }
 
-void FGameplayTagStackContainer::BroadcastTagStackChangeMessage(FGameplayTag Tag, int32 CurrentStack, int32 MaxStack)
+FGameplayTagStackCountChangeMessage FGameplayTagStackContainer::MakeChangeMessage(FGameplayTag Tag, int32 Value, int32 MaxValue, float Rate) const
 {
 	FGameplayTagStackCountChangeMessage Message;
 	Message.OwningObject = OwnerObject;
 	Message.Tag = Tag;
-	Message.Count = CurrentStack;
-	Message.MaxCount = MaxStack;
+	Message.Count = Value;
+	Message.MaxCount = MaxValue;
 
-	auto& MessageSystem{ UGameplayMessageSubsystem::Get(OwnerObject->GetWorld()) };
-	MessageSystem.BroadcastMessage(TAG_Message_TagStackCountChange, Message);
+	return Message;
 }
 
 
-void FGameplayTagStackContainer::SetMaxStack(FGameplayTag Tag, int32 MaxStackCount, bool bCanAddNewTag)
+void FGameplayTagStackContainer::PredictStack(FGameplayTag Tag, int32 Delta, int32 PredictionId)
 {
-	if (!Tag.IsValid())
-	{
-		UE_LOG(LogGameCore_Framework, Warning, TEXT("An invalid tag was passed to AddMaxStack"));
+	FOps::PredictValue(*this, Tag, Delta, PredictionId, TEXT("PredictStack"));
+}
 
-		return;
-	}
+void FGameplayTagStackContainer::AcknowledgePrediction(int32 PredictionId)
+{
+	FOps::AcknowledgePrediction(*this, PredictionId);
+}
 
-	// Find Stack, and set max stack count
+void FGameplayTagStackContainer::ClearPredictions()
+{
+	FOps::ClearPredictions(*this);
+}
 
-	for (auto& Stack : Stacks)
-	{
-		if (Stack.Match(Tag))
-		{
-			Stack.ChangeMaxStackValue(MaxStackCount);
 
-			RefreshFastStacks(EStackChangeType::AddOrChange, Tag, Stack);
+void FGameplayTagStackContainer::BeginBatch()
+{
+	FOps::BeginBatch(*this);
+}
 
-			MarkItemDirty(Stack);
+void FGameplayTagStackContainer::EndBatch()
+{
+	FOps::EndBatch(*this);
+}
 
-			return;
-		}
-	}
+void FGameplayTagStackContainer::ApplyStackDeltas(TConstArrayView<FGameplayTagStackDelta> Deltas, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	FOps::ApplyDeltas(*this, Deltas, bCanAddNewTag, bRemoveTagAtZero, TEXT("ApplyStackDeltas"));
+}
 
-	// Add Stack
 
-	if (bCanAddNewTag)
+void FGameplayTagStackContainer::SetMaxStack(FGameplayTag Tag, int32 MaxStackCount, bool bCanAddNewTag)
+{
+	if (FOps::CheckTag(Tag, TEXT("SetMaxStack")))
 	{
-		auto& NewStack{ Stacks.Emplace_GetRef(Tag, 0, MaxStackCount) };
-
-		RefreshFastStacks(EStackChangeType::AddOrChange, Tag, NewStack);
-
-		MarkItemDirty(NewStack);
-
-		return;
+		FOps::SetMaxValue(*this, Tag, MaxStackCount, bCanAddNewTag);
 	}
 }
 
 int32 FGameplayTagStackContainer::SetStack(FGameplayTag Tag, int32 StackCount, bool bCanAddNewTag, bool bRemoveTagAtZero)
 {
-	if (!Tag.IsValid())
+	if (!FOps::CheckTag(Tag, TEXT("SetStack")))
 	{
-		UE_LOG(LogGameCore_Framework, Warning, TEXT("An invalid tag was passed to SetStack"));
-
 		return 0;
 	}
 
-	// Find stack, and set count
-
-	for (auto It{ Stacks.CreateIterator() }; It; ++It)
-	{
-		auto& Stack{ *It };
-
-		if (Stack.Match(Tag))
-		{
-			// Set Tag count
-
-			if (StackCount > 0)
-			{
-				const auto NewCount{ Stack.ChangeStackValue(StackCount) };
-
-				RefreshFastStacks(EStackChangeType::AddOrChange, Tag, Stack);
-
-				MarkItemDirty(Stack);
-
-				return NewCount;
-			}
-
-			// Remove Tag
+	// A new tag is never added when bRemoveTagAtZero is set
 
-			else if (bRemoveTagAtZero)
-			{
-				It.RemoveCurrent();
-
-				RefreshFastStacks(EStackChangeType::Remove, Tag);
-
-				MarkArrayDirty();
-
-				return 0;
-			}
-
-			// Remove tag count
-
-			else
-			{
-				Stack.ChangeStackValue(StackCount);
-
-				RefreshFastStacks(EStackChangeType::AddOrChange, Tag, Stack);
-
-				MarkItemDirty(Stack);
+	return FOps::SetValue(*this, Tag, StackCount, bCanAddNewTag && !bRemoveTagAtZero, bRemoveTagAtZero);
+}
 
-				return 0;
-			}
-		}
+int32 FGameplayTagStackContainer::AddStack(FGameplayTag Tag, int32 StackCount, bool bCanAddNewTag)
+{
+	if (!FOps::CheckTag(Tag, TEXT("AddStack")) || (StackCount < 0))
+	{
+		return 0;
 	}
 
-	// Add Tags
+	return FOps::AddValue(*this, Tag, StackCount, bCanAddNewTag, false);
+}
 
-	if (bCanAddNewTag && !bRemoveTagAtZero)
+int32 FGameplayTagStackContainer::RemoveStack(FGameplayTag Tag, int32 StackCount, bool bRemoveTagAtZero)
+{
+	if (!FOps::CheckTag(Tag, TEXT("RemoveStack")) || (StackCount <= 0))
 	{
-		auto& NewStack{ Stacks.Emplace_GetRef(Tag, StackCount, -1) };
+		return 0;
+	}
 
-		RefreshFastStacks(EStackChangeType::AddOrChange, Tag, NewStack);
+	return FOps::AddValue(*this, Tag, -StackCount, false, bRemoveTagAtZero);
+}
 
-		MarkItemDirty(NewStack);
 
-		return StackCount;
-	}
+int32 FGameplayTagStackContainer::GetStackCount(FGameplayTag Tag) const
+{
+	return FOps::GetValue(*this, Tag);
+}
 
-	return 0;
+int32 FGameplayTagStackContainer::GetMaxStackCount(FGameplayTag Tag) const
+{
+	return FOps::GetMaxValue(*this, Tag);
 }
 
-int32 FGameplayTagStackContainer::AddStack(FGameplayTag Tag, int32 StackCount, bool bCanAddNewTag)
+bool FGameplayTagStackContainer::ContainsTag(FGameplayTag Tag) const
 {
-	if (!Tag.IsValid())
-	{
-		UE_LOG(LogGameCore_Framework, Warning, TEXT("An invalid tag was passed to AddStack"));
+	return FOps::ContainsTag(*this, Tag);
+}
 
-		return 0;
-	}
+int64 FGameplayTagStackContainer::GetStackCountSum(FGameplayTag ParentTag) const
+{
+	return FOps::GetValueSum(*this, ParentTag);
+}
 
-	if (StackCount >= 0)
-	{
-		// Find Stack, and add stack count
+int32 FGameplayTagStackContainer::GetStackCountMax(FGameplayTag ParentTag) const
+{
+	return FOps::GetValueMax(*this, ParentTag);
+}
 
-		for (auto& Stack : Stacks)
-		{
-			if (Stack.Match(Tag))
-			{
-				const auto NewCount{ Stack.AddStackValue(StackCount) };
+bool FGameplayTagStackContainer::HasAnyStack(FGameplayTag ParentTag) const
+{
+	return FOps::HasAnyValue(*this, ParentTag);
+}
 
-				RefreshFastStacks(EStackChangeType::AddOrChange, Tag, Stack);
+#pragma endregion
 
-				MarkItemDirty(Stack);
 
-				return NewCount;
-			}
-		}
+//////////////////////////////////////////////////////////////////////
+// Benchmark
 
-		// Add Stack
+#pragma region Benchmark
 
-		if (bCanAddNewTag)
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand CCmdGameplayTagStackBenchmarkLookup(
+	TEXT("GameplayTagStack.BenchmarkLookup"),
+	TEXT("Compares the lookup cost of the Map and FlatArray lookup modes for 4, 16, 64 and 256 tags. Usage: GameplayTagStack.BenchmarkLookup [NumLookups=1000000]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args)
 		{
-			auto& NewStack{ Stacks.Emplace_GetRef(Tag, StackCount, -1) };
+			const auto NumLookups{ Args.IsValidIndex(0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000000 };
 
-			RefreshFastStacks(EStackChangeType::AddOrChange, Tag, NewStack);
+			FGameplayTagContainer AllTags;
+			UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, false);
 
-			MarkItemDirty(NewStack);
+			TArray<FGameplayTag> Tags;
+			AllTags.GetGameplayTagArray(Tags);
 
-			return StackCount;
-		}
-	}
+			for (const auto NumTags : { 4, 16, 64, 256 })
+			{
+				if (Tags.Num() < NumTags)
+				{
+					UE_LOG(LogGameCore_StatTagStock, Warning, TEXT("GameplayTagStack.BenchmarkLookup: Skipped %d tags (only %d tags are registered)"), NumTags, Tags.Num());
+					continue;
+				}
 
-	return 0;
-}
+				TMap<FGameplayTag, FFastGameplayTagStack> Map;
+				FFlatGameplayTagStackMap FlatMap;
 
-int32 FGameplayTagStackContainer::RemoveStack(FGameplayTag Tag, int32 StackCount, bool bRemoveTagAtZero)
-{
-	if (!Tag.IsValid())
-	{
-		UE_LOG(LogGameCore_Framework, Warning, TEXT("An invalid tag was passed to RemoveStack"));
+				for (auto Index{ 0 }; Index < NumTags; ++Index)
+				{
+					Map.Add(Tags[Index], FFastGameplayTagStack(Index, -1));
+					FlatMap.FindOrAdd(Tags[Index]) = FFastGameplayTagStack(Index, -1);
+				}
 
-		return 0;
-	}
+				auto MapSum{ int64(0) };
+				auto MapStartTime{ FPlatformTime::Seconds() };
 
-	if (StackCount > 0)
-	{
-		// Find stack, and remove count
+				for (auto Index{ 0 }; Index < NumLookups; ++Index)
+				{
+					MapSum += Map.FindChecked(Tags[Index % NumTags]).Value;
+				}
 
-		for (auto It{ Stacks.CreateIterator() }; It; ++It)
-		{
-			auto& Stack{ *It };
+				const auto MapTime{ FPlatformTime::Seconds() - MapStartTime };
 
-			if (Stack.Match(Tag))
-			{
-				// If 0 after application
+				auto FlatSum{ int64(0) };
+				auto FlatStartTime{ FPlatformTime::Seconds() };
 
-				if (Stack.WillBeZero(StackCount))
+				for (auto Index{ 0 }; Index < NumLookups; ++Index)
 				{
-					// When tag can be removed
+					FlatSum += FlatMap.Find(Tags[Index % NumTags])->Value;
+				}
 
-					if (bRemoveTagAtZero)
-					{
-						It.RemoveCurrent();
-						
-						RefreshFastStacks(EStackChangeType::Remove, Tag);
+				const auto FlatTime{ FPlatformTime::Seconds() - FlatStartTime };
 
-						MarkArrayDirty();
-					}
+				check(MapSum == FlatSum);
 
-					// When tag cannot be removed
+				UE_LOG(LogGameCore_StatTagStock, Log, TEXT("GameplayTagStack.BenchmarkLookup: %3d tags, Map %.2f ns/lookup, FlatArray %.2f ns/lookup"),
+					NumTags, (MapTime * 1e9) / NumLookups, (FlatTime * 1e9) / NumLookups);
+			}
+		}));
 
-					else
-					{
-						Stack.AddStackValue(-StackCount);
+static FAutoConsoleCommand CCmdGameplayTagStackBenchmarkNetSerialize(
+	TEXT("GameplayTagStack.BenchmarkNetSerialize"),
+	TEXT("Compares the bytes per update of the compact NetSerialize and the full int32 layout of FGameplayTagStack. Usage: GameplayTagStack.BenchmarkNetSerialize [NumTags=64]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args)
+		{
+			const auto NumTags{ Args.IsValidIndex(0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 64 };
 
-						RefreshFastStacks(EStackChangeType::AddOrChange, Tag, Stack);
+			FGameplayTagContainer AllTags;
+			UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, false);
 
-						MarkItemDirty(Stack);
-					}
+			TArray<FGameplayTag> Tags;
+			AllTags.GetGameplayTagArray(Tags);
 
-					return 0;
-				}
+			if (Tags.IsEmpty())
+			{
+				UE_LOG(LogGameCore_StatTagStock, Warning, TEXT("GameplayTagStack.BenchmarkNetSerialize: No gameplay tags are registered"));
+				return;
+			}
 
-				// If it remains after application
+			FNetBitWriter CompactWriter(nullptr, 0);
+			FNetBitWriter FullWriter(nullptr, 0);
 
-				else
-				{
-					const auto NewCount{ Stack.AddStackValue(-StackCount) };
-					
-					RefreshFastStacks(EStackChangeType::AddOrChange, Tag, Stack);
+			for (auto Index{ 0 }; Index < NumTags; ++Index)
+			{
+				// Typical stat values: small counts, a quarter of the tags with a max stack count
 
-					MarkItemDirty(Stack);
+				auto Tag{ Tags[Index % Tags.Num()] };
+				auto StackCount{ Index % 100 };
+				auto MaxStackCount{ (Index % 4 == 0) ? 100 : -1 };
 
-					return NewCount;
-				}
+				FGameplayTagStack Stack(Tag, StackCount, MaxStackCount);
+
+				auto bSuccess{ true };
+				Stack.NetSerialize(CompactWriter, nullptr, bSuccess);
+
+				Tag.NetSerialize(FullWriter, nullptr, bSuccess);
+				FullWriter << StackCount;
+				FullWriter << MaxStackCount;
 			}
-		}
-	}
 
-	return 0;
-}
+			const auto CompactBytes{ float(CompactWriter.GetNumBits()) / 8.0f / NumTags };
+			const auto FullBytes{ float(FullWriter.GetNumBits()) / 8.0f / NumTags };
+
+			UE_LOG(LogGameCore_StatTagStock, Log, TEXT("GameplayTagStack.BenchmarkNetSerialize: %d tags, Compact %.2f bytes/update, Full %.2f bytes/update (%.1f%%)"),
+				NumTags, CompactBytes, FullBytes, (FullBytes > 0.0f) ? (CompactBytes / FullBytes) * 100.0f : 0.0f);
+		}));
+
+#endif
 
 #pragma endregion
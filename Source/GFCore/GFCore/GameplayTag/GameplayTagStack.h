@@ -5,9 +5,94 @@
 #include "Net/Serialization/FastArraySerializer.h"
 
 #include "GameplayTagContainer.h"
+#include "GameplayTag/GameplayTagStackReplicationPolicy.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Algo/BinarySearch.h"
+
+#include <atomic>
+#include <type_traits>
 
 #include "GameplayTagStack.generated.h"
 
+struct FGameplayMessageListenerHandle;
+struct FGameplayTagStackCountChangeMessage;
+struct FGameplayTagStackContainer;
+template<typename ContainerType> struct TGameplayTagStackOps;
+
+
+/**
+ * How the TagStack container broadcasts change messages
+ */
+UENUM(BlueprintType)
+enum class EGameplayTagStackMessagePolicy : uint8
+{
+	// A message is broadcast immediately for every change
+	Immediate,
+
+	// Only the latest change of each tag is broadcast once per frame
+	CoalescePerFrame
+};
+
+
+/**
+ * Which data structure the TagStack container uses for quick query of tag stacks
+ */
+UENUM(BlueprintType)
+enum class EGameplayTagStackLookupMode : uint8
+{
+	// Hash map (suitable for containers with many tags)
+	Map,
+
+	// Sorted array with inline storage (suitable for containers with a few tags, no allocation up to 16 tags)
+	FlatArray
+};
+
+
+/**
+ * Rules for the values of the tag stacks, shared by all value types
+ * 
+ * Tips:
+ *	Values are clamped to [0, MaxValue] and a max of 0 or less means no max (-1).
+ *	When Rate is not 0, the current value is Value + Rate * (ServerTime - RateStartTime), evaluated lazily on read.
+ */
+template<typename ValueType>
+struct TGameplayTagValueStackTraits
+{
+	//
+	// Type used to sum the values of many tags without overflowing
+	//
+	using FSum = std::conditional_t<std::is_floating_point_v<ValueType>, double, int64>;
+
+	static constexpr ValueType NoMax{ ValueType(-1) };
+
+	static ValueType ClampValue(ValueType NewValue, ValueType MaxValue)
+	{
+		return (MaxValue != NoMax) ? FMath::Clamp(NewValue, ValueType(0), MaxValue) : FMath::Max(NewValue, ValueType(0));
+	}
+
+	static ValueType NormalizeMax(ValueType NewMaxValue)
+	{
+		return (NewMaxValue <= ValueType(0)) ? NoMax : NewMaxValue;
+	}
+
+	/**
+	 * Returns the value of the stack at the server time, applying the rate since the value was set
+	 */
+	template<typename StackType>
+	static ValueType EvaluateValue(const StackType& Stack, double ServerTime)
+	{
+		if (Stack.Rate == 0.0f)
+		{
+			return Stack.Value;
+		}
+
+		const auto Elapsed{ FMath::Max(ServerTime - Stack.RateStartTime, 0.0) };
+
+		return ClampValue(ValueType(double(Stack.Value) + double(Stack.Rate) * Elapsed), Stack.MaxValue);
+	}
+};
+
 
 /**
  * Represents one stack of a gameplay tag (tag + count)
@@ -18,16 +103,16 @@ struct GFCORE_API FGameplayTagStack : public FFastArraySerializerItem
 	GENERATED_BODY()
 
 	friend struct FGameplayTagStackContainer;
-	friend struct FFastGameplayTagStack;
+	friend struct TGameplayTagStackOps<FGameplayTagStackContainer>;
 
 public:
 	FGameplayTagStack(){}
 
 	FGameplayTagStack(FGameplayTag InTag, int32 InStackCount, int32 InMaxStackCount = -1)
 		: Tag(InTag)
-		, StackCount(InStackCount)
+		, MaxStackCount(TGameplayTagValueStackTraits<int32>::NormalizeMax(InMaxStackCount))
 	{
-		ChangeMaxStackValue(InMaxStackCount);
+		StackCount = TGameplayTagValueStackTraits<int32>::ClampValue(InStackCount, MaxStackCount);
 	}
 
 private:
@@ -37,95 +122,579 @@ private:
 	UPROPERTY()
 	int32 StackCount{ 0 };
 
+	//
+	// Max stack count (-1 if there is no max)
+	//
 	UPROPERTY()
 	int32 MaxStackCount{ -1 };
 
+public:
+	FString GetDebugString() const;
+
+	/**
+	 * Compact serialization for replication
+	 * 
+	 * Tips:
+	 *	Tag uses the net index of the gameplay tag (when fast replication is enabled in the project settings).
+	 *	StackCount is zig-zag and variable-length encoded, MaxStackCount is only written when it is set.
+	 */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayTagStack> : public TStructOpsTypeTraitsBase2<FGameplayTagStack>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+
+/**
+ * List entry data for quick query of Stat tags
+ */
+USTRUCT()
+struct FFastGameplayTagStack
+{
+	GENERATED_BODY()
+public:
+	using FValue = int32;
+
+	static constexpr bool bHasRate{ false };
+
+public:
+	FFastGameplayTagStack() {}
+
+	FFastGameplayTagStack(int32 InValue, int32 InMaxValue)
+		: Value(InValue)
+		, MaxValue(InMaxValue)
+	{
+	}
+
+public:
+	UPROPERTY()
+	int32 Value{ 0 };
+
+	UPROPERTY()
+	int32 MaxValue{ -1 };
+
+	//
+	// Index of the original stack in the replicated list (validated on use and rebuilt if stale)
+	//
+	int32 StackIndex{ INDEX_NONE };
+
+};
+
+
+/**
+ * Aggregated values of all tags under a parent tag (including the parent tag itself)
+ */
+template<typename ValueType>
+struct TGameplayTagStackAggregate
+{
+public:
+	typename TGameplayTagValueStackTraits<ValueType>::FSum Sum{ 0 };
+	ValueType Max{ 0 };
+	int32 NumTags{ 0 };
+	int32 NumNonZeroTags{ 0 };
+
+	//
+	// Max needs to be recomputed because the previous max value has decreased or been removed
+	//
+	bool bMaxDirty{ false };
+};
+
+using FGameplayTagStackAggregate = TGameplayTagStackAggregate<int32>;
+
+
+/**
+ * Small flat map of tag stacks sorted by tag for quick query of Stat tags without hash allocation
+ */
+template<typename FastStackType>
+struct TFlatGameplayTagStackMap
+{
+public:
+	using FEntry = TPair<FGameplayTag, FastStackType>;
+	using FEntryArray = TArray<FEntry, TInlineAllocator<16>>;
+
 private:
+	FEntryArray Entries;
+
+public:
+	FastStackType* Find(FGameplayTag Tag)
+	{
+		const auto Index{ LowerBound(Tag) };
+		return (Entries.IsValidIndex(Index) && (Entries[Index].Key == Tag)) ? &Entries[Index].Value : nullptr;
+	}
+
+	const FastStackType* Find(FGameplayTag Tag) const
+	{
+		const auto Index{ LowerBound(Tag) };
+		return (Entries.IsValidIndex(Index) && (Entries[Index].Key == Tag)) ? &Entries[Index].Value : nullptr;
+	}
+
+	FastStackType& FindOrAdd(FGameplayTag Tag)
+	{
+		const auto Index{ LowerBound(Tag) };
+
+		if (Entries.IsValidIndex(Index) && (Entries[Index].Key == Tag))
+		{
+			return Entries[Index].Value;
+		}
+
+		Entries.Insert(FEntry(Tag, FastStackType()), Index);
+
+		return Entries[Index].Value;
+	}
+
+	void Remove(FGameplayTag Tag)
+	{
+		const auto Index{ LowerBound(Tag) };
+
+		if (Entries.IsValidIndex(Index) && (Entries[Index].Key == Tag))
+		{
+			Entries.RemoveAt(Index);
+		}
+	}
+
+	void Reset() { Entries.Reset(); }
+
+	void Reserve(int32 Number) { Entries.Reserve(Number); }
+
 	/**
-	 * Returns whether the tag is correct or not.
+	 * Add an entry without keeping the order (Sort must be called before the next query)
 	 */
-	bool Match(const FGameplayTag OtherTag) const;
+	void AddUnsorted(FGameplayTag Tag, const FastStackType& Stack) { Entries.Emplace(Tag, Stack); }
 
 	/**
-	 * Returns whether the tag is correct or not.
+	 * Sort the entries added by AddUnsorted
 	 */
-	bool WillBeZero(int32 NumToRemove) const;
+	void Sort()
+	{
+		Entries.Sort(
+			[](const FEntry& A, const FEntry& B)
+			{
+				return A.Key.GetTagName().FastLess(B.Key.GetTagName());
+			}
+		);
+	}
+
+	int32 Num() const { return Entries.Num(); }
+
+	TArrayView<FEntry> GetEntries() { return Entries; }
+	TConstArrayView<FEntry> GetEntries() const { return Entries; }
 
 private:
 	/**
-	 * Add the specified number to Stack
-	 * 
-	 * Tips:
-	 *	If a negative value is entered, it is subtracted.
+	 * Returns the index of the first entry that is not less than the tag
 	 */
-	int32 AddStackValue(int32 NumToAdd);
+	int32 LowerBound(FGameplayTag Tag) const
+	{
+		// Sorted by the name index, which is cheaper to compare than the tag string
+
+		return Algo::LowerBoundBy(Entries, Tag.GetTagName(),
+			[](const FEntry& Entry)
+			{
+				return Entry.Key.GetTagName();
+			},
+			[](const FName& A, const FName& B)
+			{
+				return A.FastLess(B);
+			}
+		);
+	}
+
+};
+
+using FFlatGameplayTagStackMap = TFlatGameplayTagStackMap<FFastGameplayTagStack>;
+
+
+/**
+ * Immutable copy of the tag stacks of a container that can be read from any thread
+ * 
+ * Tips:
+ *	Stacks with a rate store the value set at RateStartTime, so GetValue evaluates the rate instead of returning it as is.
+ */
+template<typename FastStackType>
+struct TGameplayTagStackSnapshot
+{
+public:
+	using FValue = typename FastStackType::FValue;
+
+public:
+	//
+	// Incremented each time a new snapshot is published for the container
+	//
+	uint32 Version{ 0 };
+
+	//
+	// Tag stacks at the time the snapshot was published
+	//
+	TFlatGameplayTagStackMap<FastStackType> Stacks;
 
+	//
+	// Server time and platform time when the snapshot was published (only set for stacks with a rate)
+	//
+	double ServerTime{ 0.0 };
+	double PlatformTime{ 0.0 };
+
+public:
 	/**
-	 * Set the stack count
+	 * Returns the current value of the tag, evaluating its rate at the current server time
 	 * 
 	 * Tips:
-	 *	If MaxStacks is set, it is limited to that range
+	 *	The server time cannot be read from other threads, so it is estimated from the platform time elapsed since publishing.
 	 */
-	int32 ChangeStackValue(int32 NewCount);
+	FValue GetValue(FGameplayTag Tag) const
+	{
+		if constexpr (FastStackType::bHasRate)
+		{
+			return GetValueAtTime(Tag, ServerTime + (FPlatformTime::Seconds() - PlatformTime));
+		}
+		else
+		{
+			return GetValueAtTime(Tag, 0.0);
+		}
+	}
 
 	/**
-	 * MaxStacks sets and limits the current count
+	 * Returns the value of the tag at the server time (the stored value if the stack has no rate)
 	 */
-	int32 ChangeMaxStackValue(int32 NewCount);
+	FValue GetValueAtTime(FGameplayTag Tag, double InServerTime) const
+	{
+		const auto* FastStack{ Stacks.Find(Tag) };
+
+		if (!FastStack)
+		{
+			return FValue(0);
+		}
+
+		if constexpr (FastStackType::bHasRate)
+		{
+			return TGameplayTagValueStackTraits<FValue>::EvaluateValue(*FastStack, InServerTime);
+		}
+		else
+		{
+			return FastStack->Value;
+		}
+	}
 
-public:
-	FString GetDebugString() const;
+	FValue GetMaxValue(FGameplayTag Tag) const
+	{
+		const auto* FastStack{ Stacks.Find(Tag) };
+		return FastStack ? FastStack->MaxValue : TGameplayTagValueStackTraits<FValue>::NoMax;
+	}
+
+	bool ContainsTag(FGameplayTag Tag) const { return Stacks.Find(Tag) != nullptr; }
 
 };
 
+template<typename FastStackType>
+using TGameplayTagStackSnapshotPtr = TSharedPtr<const TGameplayTagStackSnapshot<FastStackType>, ESPMode::ThreadSafe>;
+
+using FGameplayTagStackSnapshot = TGameplayTagStackSnapshot<FFastGameplayTagStack>;
+using FGameplayTagStackSnapshotPtr = TGameplayTagStackSnapshotPtr<FFastGameplayTagStack>;
+
 
 /**
- * List entry data for quick query of Stat tags
+ * Publishes snapshots of a container on the game thread for lock-free reads from other threads
+ * 
+ * Tips:
+ *	Readers get a shared reference to the snapshot, so a replaced snapshot is freed only after the last reader releases it.
+ *	Each snapshot is published in the slot not currently read. Readers count themselves in the current slot while copying
+ *	the reference and retry if the slot was switched meanwhile, so they never wait for the game thread.
+ *	Publishing only waits for the readers still copying the reference of the previous slot before releasing it.
+ *	Copying creates an empty publisher, since each container publishes its own snapshots.
  */
-USTRUCT()
-struct FFastGameplayTagStack
+template<typename FastStackType>
+class TGameplayTagStackSnapshotPublisher
 {
-	GENERATED_BODY()
 public:
-	FFastGameplayTagStack() {}
+	using FSnapshot = TGameplayTagStackSnapshot<FastStackType>;
+	using FSnapshotPtr = TGameplayTagStackSnapshotPtr<FastStackType>;
+
+public:
+	TGameplayTagStackSnapshotPublisher() {}
+	TGameplayTagStackSnapshotPublisher(const TGameplayTagStackSnapshotPublisher&) {}
+	TGameplayTagStackSnapshotPublisher& operator=(const TGameplayTagStackSnapshotPublisher&) { return *this; }
+
+private:
+	FSnapshotPtr Slots[2];
 
-	FFastGameplayTagStack(int32 InStackCount, int32 InMaxStackCount)
-		: StackCount(InStackCount)
-		, MaxStackCount(InMaxStackCount)
+	//
+	// Index of the slot holding the latest snapshot
+	//
+	std::atomic<uint32> CurrentSlot{ 0 };
+
+	//
+	// Number of readers copying the reference in each slot
+	//
+	mutable std::atomic<int32> NumReaders[2]{};
+
+	uint32 LastVersion{ 0 };
+
+public:
+	/**
+	 * Publish a new snapshot and release the reference to the previous one (game thread only)
+	 */
+	void Publish(TSharedRef<FSnapshot, ESPMode::ThreadSafe> NewSnapshot)
 	{
+		check(IsInGameThread());
+
+		NewSnapshot->Version = ++LastVersion;
+
+		Store(MoveTemp(NewSnapshot));
 	}
 
-	FFastGameplayTagStack(const FGameplayTagStack& OriginalStack)
-		: StackCount(OriginalStack.StackCount)
-		, MaxStackCount(OriginalStack.MaxStackCount)
+	/**
+	 * Release the reference to the current snapshot (game thread only)
+	 */
+	void Reset()
+	{
+		check(IsInGameThread());
+
+		Store(nullptr);
+	}
+
+	/**
+	 * Returns the latest published snapshot (or nullptr if not published yet). Can be called from any thread.
+	 */
+	FSnapshotPtr Get() const
 	{
+		while (true)
+		{
+			const auto Slot{ CurrentSlot.load() };
+
+			NumReaders[Slot].fetch_add(1);
+
+			// The reference is only copied if the slot is still current once the reader is counted,
+			// otherwise the game thread may already be releasing it
+
+			if (CurrentSlot.load() == Slot)
+			{
+				FSnapshotPtr Snapshot{ Slots[Slot] };
+
+				NumReaders[Slot].fetch_sub(1);
+
+				return Snapshot;
+			}
+
+			NumReaders[Slot].fetch_sub(1);
+		}
+	}
+
+private:
+	/**
+	 * Store the snapshot in the other slot, make it current and release the previous one
+	 */
+	void Store(FSnapshotPtr NewSnapshot)
+	{
+		const auto OldSlot{ CurrentSlot.load() };
+		const auto NewSlot{ OldSlot ^ 1u };
+
+		// The other slot was emptied by the previous store, and readers that counted themselves in it since then
+		// see that it is not current and do not touch it
+
+		Slots[NewSlot] = MoveTemp(NewSnapshot);
+
+		CurrentSlot.store(NewSlot);
+
+		// Readers copying the previous reference finish in a few instructions, and those arriving now retry on the new slot
+
+		while (NumReaders[OldSlot].load() > 0)
+		{
+			FPlatformProcess::Yield();
+		}
+
+		Slots[OldSlot].Reset();
 	}
 
+};
+
+using FGameplayTagStackSnapshotPublisher = TGameplayTagStackSnapshotPublisher<FFastGameplayTagStack>;
+
+
+/**
+ * Value changes predicted locally for a tag that have not been acknowledged by the server yet
+ */
+template<typename ValueType>
+struct TPredictedGameplayTagStack
+{
 public:
-	UPROPERTY()
-	int32 StackCount{ 0 };
+	// Pairs of prediction ID and predicted delta, in the order they were predicted
+	TArray<TPair<int32, ValueType>, TInlineAllocator<4>> Deltas;
 
-	UPROPERTY()
-	int32 MaxStackCount{ -1 };
+	// Values of the last change message broadcast for the tag
+	ValueType LastBroadcastValue{ 0 };
+	ValueType LastBroadcastMaxValue{ TGameplayTagValueStackTraits<ValueType>::NoMax };
+};
+
+
+/**
+ * Non-replicated state of a TagStack container managed by TGameplayTagStackOps
+ * 
+ * Tips:
+ *	Kept out of the USTRUCT containers so that the state is declared once for all value types.
+ */
+template<typename FastStackType>
+struct TGameplayTagStackContainerState
+{
+public:
+	using FValue = typename FastStackType::FValue;
+
+public:
+	//
+	// Which data structure is used for quick query of tag stacks
+	//
+	EGameplayTagStackLookupMode LookupMode{ EGameplayTagStackLookupMode::Map };
+
+	//
+	// Nesting depth of the current batch (dirty marks and change messages are deferred while greater than 0)
+	//
+	int32 BatchDepth{ 0 };
+
+	//
+	// Tags whose stack items need to be marked dirty at the end of the batch
+	//
+	TSet<FGameplayTag> PendingDirtyTags;
+
+	//
+	// Tags whose change message needs to be broadcast at the end of the batch (in the order they first changed)
+	//
+	TSet<FGameplayTag> PendingChangedTags;
+
+	//
+	// Whether aggregates for each parent tag are maintained on every change
+	//
+	bool bTrackParentAggregates{ false };
+
+	//
+	// Aggregated values for each parent tag of the tags in the container
+	//
+	mutable TMap<FGameplayTag, TGameplayTagStackAggregate<FValue>> ParentAggregates;
+
+	//
+	// Whether a snapshot readable from other threads is published at the end of each mutation batch
+	//
+	bool bPublishSnapshots{ false };
+
+	//
+	// Snapshot needs to be published at the end of the batch
+	//
+	bool bSnapshotDirty{ false };
 
+	TGameplayTagStackSnapshotPublisher<FastStackType> SnapshotPublisher;
+
+	//
+	// Whether the connection currently being serialized owns the actor of the container
+	//
+	bool bIsSerializingForOwner{ false };
+
+	//
+	// Whether any replication policy is set in the developer settings (every stack is replicated to all connections if not)
+	//
+	bool bHasReplicationPolicies{ false };
+
+	//
+	// Replication policy of each tag resolved from the developer settings
+	//
+	TMap<FGameplayTag, EGameplayTagStackReplicationPolicy> ReplicationPolicies;
+
+	//
+	// Revision of the developer settings policies that ReplicationPolicies was resolved from
+	//
+	uint32 ReplicationPoliciesRevision{ 0 };
+
+	//
+	// Number of mutations and replicated updates of the container that were skipped because they changed nothing
+	//
+	uint32 NumElidedMutations{ 0 };
+
+	//
+	// Pending predictions for each tag (only used on the predicting client)
+	//
+	TMap<FGameplayTag, TPredictedGameplayTagStack<FValue>> PredictedStacks;
+
+	//
+	// Whether a new acknowledgement was received and the predictions it covers have not been resolved yet (client only)
+	//
+	bool bAcknowledgementPending{ false };
 };
 
 
 /**
- * Container of gameplay tag stacks 
+ * Change in the stack count of a tag to be applied in a batch
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagStackDelta
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagStackDelta() {}
+
+	FGameplayTagStackDelta(FGameplayTag InTag, int32 InDelta)
+		: Tag(InTag)
+		, Delta(InDelta)
+	{}
+
+public:
+	//
+	// Tag whose stack count will be changed
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag Tag;
+
+	//
+	// Number of stacks to add (subtracted if negative)
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	int32 Delta{ 0 };
+
+};
+
+
+/**
+ * Container of gameplay tag stacks
+ * 
+ * Tips:
+ *	The logic is shared with the int64 and float containers through TGameplayTagStackOps.
  */
 USTRUCT(BlueprintType)
 struct GFCORE_API FGameplayTagStackContainer : public FFastArraySerializer
 {
 	GENERATED_BODY()
+
+	friend struct TGameplayTagStackOps<FGameplayTagStackContainer>;
+
 public:
-	FGameplayTagStackContainer() 
+	using FItem = FGameplayTagStack;
+	using FFastStack = FFastGameplayTagStack;
+	using FValue = int32;
+	using FDelta = FGameplayTagStackDelta;
+	using FMessage = FGameplayTagStackCountChangeMessage;
+	using FOps = TGameplayTagStackOps<FGameplayTagStackContainer>;
+
+	static constexpr bool bHasRate{ false };
+
+	//
+	// Properties of the item holding the value and the max value (named after the stack count for the data saved with them)
+	//
+	static constexpr auto ItemValue{ &FGameplayTagStack::StackCount };
+	static constexpr auto ItemMaxValue{ &FGameplayTagStack::MaxStackCount };
+
+public:
+	FGameplayTagStackContainer()
 		: OwnerObject(nullptr)
 	{}
 
-	FGameplayTagStackContainer(UObject* InOwnerObject)
+	FGameplayTagStackContainer(UObject* InOwnerObject, EGameplayTagStackMessagePolicy InMessagePolicy = EGameplayTagStackMessagePolicy::Immediate, EGameplayTagStackLookupMode InLookupMode = EGameplayTagStackLookupMode::Map)
 		: OwnerObject(InOwnerObject)
-	{}
+		, MessagePolicy(InMessagePolicy)
+	{
+		State.LookupMode = InLookupMode;
+	}
 
 	//////////////////////////////////////////////////////////
 	// Container parameters
@@ -137,17 +706,87 @@ public:
 	TArray<FGameplayTagStack> Stacks;
 
 	//
-	// Accelerated list of tag stacks for queries
+	// Accelerated list of tag stacks for queries (used when LookupMode is Map)
 	//
 	UPROPERTY(NotReplicated)
 	TMap<FGameplayTag, FFastGameplayTagStack> FastStacks;
 
+	//
+	// Accelerated sorted list of tag stacks for queries (used when LookupMode is FlatArray)
+	//
+	FFlatGameplayTagStackMap FlatStacks;
+
 	//
 	// Owner of this container.
 	//
 	UPROPERTY(NotReplicated)
 	TObjectPtr<UObject> OwnerObject;
 
+	//
+	// How change messages are broadcast for this container
+	//
+	UPROPERTY(NotReplicated)
+	EGameplayTagStackMessagePolicy MessagePolicy{ EGameplayTagStackMessagePolicy::Immediate };
+
+protected:
+	//
+	// Latest prediction ID acknowledged by the server (on the client, the latest one received)
+	//
+	// Tips:
+	//	Written by NetDeltaSerialize in a header before the items, and only for the owning connection.
+	//
+	UPROPERTY(NotReplicated)
+	int32 LastAcknowledgedPredictionId{ 0 };
+
+	//
+	// Lookup, batch, aggregate, snapshot, replication and prediction state
+	//
+	TGameplayTagStackContainerState<FFastGameplayTagStack> State;
+
+
+	///////////////////////////////////////////////////////////
+	// Lookup
+public:
+	/**
+	 * Change the data structure used for quick query of tag stacks, moving the current entries
+	 */
+	void SetLookupMode(EGameplayTagStackLookupMode NewLookupMode);
+
+	EGameplayTagStackLookupMode GetLookupMode() const { return State.LookupMode; }
+
+
+	///////////////////////////////////////////////////////////
+	// Parent Aggregates
+public:
+	/**
+	 * Enable or disable maintaining aggregates for each parent tag
+	 * 
+	 * Tips:
+	 *	While enabled, GetStackCountSum, GetStackCountMax and HasAnyStack are O(1).
+	 *	While disabled, they iterate over all tag stacks.
+	 *	Either way, the aggregates include the pending predictions like GetStackCount.
+	 */
+	void SetTrackParentAggregates(bool bEnabled);
+
+	bool IsTrackingParentAggregates() const { return State.bTrackParentAggregates; }
+
+
+	///////////////////////////////////////////////////////////
+	// Snapshot
+public:
+	/**
+	 * Enable or disable publishing snapshots readable from other threads
+	 */
+	void SetPublishSnapshots(bool bEnabled);
+
+	/**
+	 * Returns the latest published snapshot (or nullptr if publishing is disabled)
+	 * 
+	 * Tips:
+	 *	Can be called from any thread. The snapshot stays valid for as long as the returned pointer is kept.
+	 */
+	FGameplayTagStackSnapshotPtr GetSnapshot() const { return State.SnapshotPublisher.Get(); }
+
 
 	///////////////////////////////////////////////////////////
 	// Replication
@@ -156,39 +795,109 @@ public:
 	void PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize);
 	void PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize);
 
-	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	/**
+	 * Filters the stacks by their replication policy for the connection currently being serialized
+	 */
+	template<typename Type, typename SerializerType>
+	bool ShouldWriteFastArrayItem(const Type& Item, const bool bIsWritingOnClient)
 	{
-		return FFastArraySerializer::FastArrayDeltaSerialize<FGameplayTagStack, FGameplayTagStackContainer>(Stacks, DeltaParms, *this);
+		return TGameplayTagStackOps<SerializerType>::ShouldWriteItem(*this, Item, bIsWritingOnClient);
 	}
 
+	uint32 GetNumElidedMutations() const { return State.NumElidedMutations; }
+
 
 	///////////////////////////////////////////////////////////
-	// Change and Notify
+	// Messages
+public:
+	/**
+	 * Register to receive the change messages of the specified tag of this container only
+	 * 
+	 * Tips:
+	 *	If Tag is empty, the changes of all tags of this container are received.
+	 *	Unlike listening on TAG_Message_TagStackCountChange, changes of other owners do not call the callback.
+	 */
+	FGameplayMessageListenerHandle RegisterStackChangeListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagStackCountChangeMessage&)>&& Callback) const;
+
 protected:
+	static FGameplayTag GetMessageChannel();
+
+	FGameplayTagStackCountChangeMessage MakeChangeMessage(FGameplayTag Tag, int32 Value, int32 MaxValue, float Rate) const;
+
+
+	///////////////////////////////////////////////////////////
+	// Prediction
+public:
 	/**
-	 * What changes are made when the TagStack is modified
+	 * Predict a stack count change on the client ahead of the server
+	 * 
+	 * Tips:
+	 *	The predicted value is returned by GetStackCount, included in the aggregates and snapshots, and broadcast
+	 *	immediately (or at the end of the batch).
+	 *	Does nothing with authority, since the server applies the change itself.
+	 *	PredictionId must increase for each prediction of this container and be passed to the server,
+	 *	which must call AcknowledgePrediction after applying (or rejecting) the change.
+	 *	When the acknowledgement is replicated, the prediction is replaced with the replicated value,
+	 *	and a change message is broadcast only if the value differs from the predicted one.
 	 */
-	enum class EStackChangeType
+	void PredictStack(FGameplayTag Tag, int32 Delta, int32 PredictionId);
+
+	/**
+	 * Acknowledge the predictions of the client up to the ID on the server after applying or rejecting them
+	 * 
+	 * Tips:
+	 *	The acknowledgement belongs to the container, so it also reaches the client when the server has no stack of
+	 *	the predicted tag or the stack is not replicated to the client.
+	 */
+	void AcknowledgePrediction(int32 PredictionId);
+
+	/**
+	 * Discard all pending predictions and roll back to the replicated values
+	 */
+	void ClearPredictions();
+
+	/**
+	 * Returns whether the tag has predictions that have not been acknowledged yet
+	 */
+	bool HasPendingPrediction(FGameplayTag Tag) const
 	{
-		// New StatTag added or count changed
-		AddOrChange,
+		const auto* PredictedStack{ State.PredictedStacks.Find(Tag) };
+		return PredictedStack && !PredictedStack->Deltas.IsEmpty();
+	}
 
-		// StatTag is completely removed.
-		Remove
-	};
 
-protected:
+	///////////////////////////////////////////////////////////
+	// Batch
+public:
 	/**
-	 * Runs when TagStack is changed, updates FastStacks, and broadcasts messages
+	 * Start a batch of mutations
+	 * 
+	 * Tips:
+	 *	Until the matching EndBatch, each changed item is marked dirty only once and
+	 *	only one change message with the final value is broadcast for each changed tag.
+	 *	@see FGameplayTagStackBatchScope
 	 */
-	void RefreshFastStacks(EStackChangeType ChangeType, const FGameplayTag& Tag, FFastGameplayTagStack Stack = FFastGameplayTagStack());
+	void BeginBatch();
 
 	/**
-	 * Broadcast messages that the TagStack has changed through the GameplayMessageSubsystem
+	 * End a batch of mutations and apply the deferred dirty marks and change messages
 	 */
-	void BroadcastTagStackChangeMessage(FGameplayTag Tag = FGameplayTag::EmptyTag, int32 CurrentStack = 0, int32 MaxStack = -1);
+	void EndBatch();
 
+	/**
+	 * Apply the stack count changes of many tags in one pass over the stacks as a single batch
+	 * 
+	 * Tips:
+	 *	Positive deltas are added and negative deltas are removed.
+	 *	Deltas for the same tag are summed before being applied.
+	 */
+	void ApplyStackDeltas(TConstArrayView<FGameplayTagStackDelta> Deltas, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
 
+
+	///////////////////////////////////////////////////////////
+	// Mutation
 public:
 	/**
 	 * Set max number of stacks to the tag
@@ -211,21 +920,38 @@ public:
 	int32 RemoveStack(FGameplayTag Tag, int32 StackCount, bool bRemoveTagAtZero = false);
 
 
+	///////////////////////////////////////////////////////////
+	// Query
 public:
 	/**
 	 * Returns the stack count of the specified tag (or 0 if the tag is not present)
 	 */
-	int32 GetStackCount(FGameplayTag Tag) const { return FastStacks.FindRef(Tag).StackCount; }
+	int32 GetStackCount(FGameplayTag Tag) const;
 
 	/**
 	 * Returns the max stack count of the specified tag (or -1 if the tag is not present)
 	 */
-	int32 GetMaxStackCount(FGameplayTag Tag) const { return FastStacks.FindRef(Tag).MaxStackCount; }
+	int32 GetMaxStackCount(FGameplayTag Tag) const;
 
 	/**
 	 * Returns true if there is at least one stack of the specified tag
 	 */
-	bool ContainsTag(FGameplayTag Tag) const { return FastStacks.Contains(Tag); }
+	bool ContainsTag(FGameplayTag Tag) const;
+
+	/**
+	 * Returns the total stack count of the specified tag and all of its child tags
+	 */
+	int64 GetStackCountSum(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns the largest stack count among the specified tag and all of its child tags (or 0 if none is present)
+	 */
+	int32 GetStackCountMax(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns true if the specified tag or any of its child tags has at least one stack
+	 */
+	bool HasAnyStack(FGameplayTag ParentTag) const;
 
 };
 
@@ -237,3 +963,36 @@ struct TStructOpsTypeTraits<FGameplayTagStackContainer> : public TStructOpsTypeT
 		WithNetDeltaSerializer = true,
 	};
 };
+
+
+/**
+ * Scope that batches the mutations of a TagStack container of any value type
+ * 
+ * Tips:
+ *	{
+ *		FGameplayTagStackBatchScope BatchScope(Container);
+ *		Container.AddStack(...);
+ *		Container.SetStack(...);
+ *	}	// Dirty marks and change messages are applied here
+ */
+template<typename ContainerType>
+struct TGameplayTagStackBatchScope : FNoncopyable
+{
+public:
+	explicit TGameplayTagStackBatchScope(ContainerType& InContainer)
+		: Container(InContainer)
+	{
+		Container.BeginBatch();
+	}
+
+	~TGameplayTagStackBatchScope()
+	{
+		Container.EndBatch();
+	}
+
+private:
+	ContainerType& Container;
+
+};
+
+using FGameplayTagStackBatchScope = TGameplayTagStackBatchScope<FGameplayTagStackContainer>;
@@ -2,6 +2,8 @@
 
 #include "GameplayTagStackInterface.h"
 
+#include "Message/GameplayMessageSubsystem.h"
+#include "GameplayTag/GameplayTagStackMessageTypes.h"
 #include "GFCoreLogs.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GameplayTagStackInterface)
@@ -61,6 +63,18 @@ int32 IGameplayTagStackInterface::RemoveStatTagStack(FGameplayTag Tag, int32 Sta
 	return 0;
 }
 
+void IGameplayTagStackInterface::ApplyStatTagStackDeltas(const TArray<FGameplayTagStackDelta>& Deltas, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	if (auto* Container{ GetStatTags() })
+	{
+		Container->ApplyStackDeltas(Deltas, bCanAddNewTag, bRemoveTagAtZero);
+	}
+	else
+	{
+		UE_LOG(LogGameCore_Framework, Error, TEXT("IGameplayTagStackInterface::ApplyStatTagStackDeltas: StatTag is invalid, GetStatTags() not overridden or Container is invalid."));
+	}
+}
+
 
 int32 IGameplayTagStackInterface::GetStatTagStackCount(FGameplayTag Tag) const
 {
@@ -103,3 +117,80 @@ bool IGameplayTagStackInterface::HasStatTag(FGameplayTag Tag) const
 
 	return false;
 }
+
+
+int64 IGameplayTagStackInterface::GetStatTagStackCountSum(FGameplayTag ParentTag) const
+{
+	if (auto* Container{ GetStatTagsConst() })
+	{
+		return Container->GetStackCountSum(ParentTag);
+	}
+	else
+	{
+		UE_LOG(LogGameCore_Framework, Error, TEXT("IGameplayTagStackInterface::GetStatTagStackCountSum: StatTag is invalid, GetStatTagsConst() not overridden or Container is invalid."));
+	}
+
+	return 0;
+}
+
+int32 IGameplayTagStackInterface::GetStatTagStackCountMax(FGameplayTag ParentTag) const
+{
+	if (auto* Container{ GetStatTagsConst() })
+	{
+		return Container->GetStackCountMax(ParentTag);
+	}
+	else
+	{
+		UE_LOG(LogGameCore_Framework, Error, TEXT("IGameplayTagStackInterface::GetStatTagStackCountMax: StatTag is invalid, GetStatTagsConst() not overridden or Container is invalid."));
+	}
+
+	return 0;
+}
+
+bool IGameplayTagStackInterface::HasAnyStatTagStack(FGameplayTag ParentTag) const
+{
+	if (auto* Container{ GetStatTagsConst() })
+	{
+		return Container->HasAnyStack(ParentTag);
+	}
+	else
+	{
+		UE_LOG(LogGameCore_Framework, Error, TEXT("IGameplayTagStackInterface::HasAnyStatTagStack: StatTag is invalid, GetStatTagsConst() not overridden or Container is invalid."));
+	}
+
+	return false;
+}
+
+FGameplayTagStackSnapshotPtr IGameplayTagStackInterface::GetStatTagStackSnapshot() const
+{
+	if (auto* Container{ GetStatTagsConst() })
+	{
+		return Container->GetSnapshot();
+	}
+
+	return nullptr;
+}
+
+int32 IGameplayTagStackInterface::GetStatTagStackCountAnyThread(FGameplayTag Tag) const
+{
+	if (const auto Snapshot{ GetStatTagStackSnapshot() })
+	{
+		return Snapshot->GetValue(Tag);
+	}
+
+	return 0;
+}
+
+FGameplayMessageListenerHandle IGameplayTagStackInterface::RegisterStatTagStackListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagStackCountChangeMessage&)>&& Callback) const
+{
+	if (auto* Container{ GetStatTagsConst() })
+	{
+		return Container->RegisterStackChangeListener(Tag, MoveTemp(Callback));
+	}
+	else
+	{
+		UE_LOG(LogGameCore_Framework, Error, TEXT("IGameplayTagStackInterface::RegisterStatTagStackListener: GetStatTagsConst() not overridden or Container is invalid."));
+	}
+
+	return FGameplayMessageListenerHandle();
+}
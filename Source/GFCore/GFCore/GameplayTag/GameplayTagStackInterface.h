@@ -66,6 +66,19 @@ UINTERFACE(BlueprintType, meta = (CannotImplementInterfaceInBlueprint))
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "Stat", meta = (GameplayTagFilter = "Stat"))
 	virtual int32 RemoveStatTagStack(FGameplayTag Tag, int32 StackCount, bool bRemoveTagAtZero = false);
 
+	/**
+	 * Apply changes to many Tags that can be handled as statistics in Equipment in a single batch
+	 *
+	 * Tips:
+	 *	Positive deltas are added and negative deltas are removed.
+	 *	Only one change message is broadcast for each changed Tag.
+	 * 
+	 * Note:
+	 *	Authority is required
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "Stat")
+	virtual void ApplyStatTagStackDeltas(const TArray<FGameplayTagStackDelta>& Deltas, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
 	/**
 	 * Returns the number of Tags that can be handled as statistics in Equipment.
 	 *
@@ -90,5 +103,47 @@ UINTERFACE(BlueprintType, meta = (CannotImplementInterfaceInBlueprint))
 	UFUNCTION(BlueprintCallable, Category = "Stat", meta = (GameplayTagFilter = "Stat"))
 	virtual bool HasStatTag(FGameplayTag Tag) const;
 
+	/**
+	 * Returns the total number of the Tag and all of its child Tags that can be handled as statistics in Equipment.
+	 *
+	 * Tips:
+	 *	Returns 0 if not present.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Stat", meta = (GameplayTagFilter = "Stat"))
+	virtual int64 GetStatTagStackCountSum(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns the largest number among the Tag and all of its child Tags that can be handled as statistics in Equipment.
+	 *
+	 * Tips:
+	 *	Returns 0 if not present.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Stat", meta = (GameplayTagFilter = "Stat"))
+	virtual int32 GetStatTagStackCountMax(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns whether or not the Tag or any of its child Tags that can be handled as statistics has at least one stack in Equipment.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Stat", meta = (GameplayTagFilter = "Stat"))
+	virtual bool HasAnyStatTagStack(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns the latest published snapshot of the stat tag stacks (or nullptr if publishing is disabled).
+	 * 
+	 * Tips:
+	 *	Can be called from any thread. The snapshot stays valid for as long as the returned pointer is kept.
+	 */
+	virtual FGameplayTagStackSnapshotPtr GetStatTagStackSnapshot() const;
+
+	/**
+	 * Returns the stack count of the specified tag from the latest published snapshot. Can be called from any thread.
+	 */
+	virtual int32 GetStatTagStackCountAnyThread(FGameplayTag Tag) const;
+
+	/**
+	 * Register to receive the stack count changes of the specified stat tag of this object only (all stat tags if Tag is empty).
+	 */
+	virtual FGameplayMessageListenerHandle RegisterStatTagStackListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagStackCountChangeMessage&)>&& Callback) const;
+
  };
 
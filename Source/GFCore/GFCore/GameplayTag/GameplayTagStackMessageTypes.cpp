@@ -6,4 +6,6 @@
 
 
 UE_DEFINE_GAMEPLAY_TAG(TAG_Message_TagStackCountChange, "Message.Ability.TagStackCountChange");
+UE_DEFINE_GAMEPLAY_TAG(TAG_Message_TagStackInt64Change, "Message.Ability.TagStackInt64Change");
+UE_DEFINE_GAMEPLAY_TAG(TAG_Message_TagStackFloatChange, "Message.Ability.TagStackFloatChange");
 UE_DEFINE_GAMEPLAY_TAG(TAG_Stat, "Stat");
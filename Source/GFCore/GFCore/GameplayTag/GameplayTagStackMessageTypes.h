@@ -9,6 +9,8 @@
 
 
 GFCORE_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_Message_TagStackCountChange);
+GFCORE_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_Message_TagStackInt64Change);
+GFCORE_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_Message_TagStackFloatChange);
 UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_Stat);
 
 
@@ -36,3 +38,67 @@ public:
 	int32 MaxCount{ -1 };
 
 };
+
+
+/**
+ * Data of the message that informs the user that the value of an int64 TagStack has changed
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagInt64StackChangeMessage
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagInt64StackChangeMessage() {}
+
+public:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TObjectPtr<UObject> OwningObject{ nullptr };
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag Tag;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	int64 Value{ 0 };
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	int64 MaxValue{ -1 };
+
+	//
+	// Change of the value per second (the value keeps changing without further messages while this is not 0)
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float Rate{ 0.0f };
+
+};
+
+
+/**
+ * Data of the message that informs the user that the value of a float TagStack has changed
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagFloatStackChangeMessage
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagFloatStackChangeMessage() {}
+
+public:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TObjectPtr<UObject> OwningObject{ nullptr };
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag Tag;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float Value{ 0.0f };
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float MaxValue{ -1.0f };
+
+	//
+	// Change of the value per second (the value keeps changing without further messages while this is not 0)
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float Rate{ 0.0f };
+
+};
@@ -0,0 +1,82 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GameplayTagStackOps.h"
+
+#include "GameFrameworkDeveloperSettings.h"
+
+#include "Engine/World.h"
+#include "Engine/PackageMapClient.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/GameStateBase.h"
+#include "Components/ActorComponent.h"
+
+
+DEFINE_STAT(STAT_GameplayTagStack_NumMutations);
+DEFINE_STAT(STAT_GameplayTagStack_NumElidedMutations);
+
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayTagStackOpsHelpers
+
+#pragma region FGameplayTagStackOpsHelpers
+
+const AActor* FGameplayTagStackOpsHelpers::GetOwnerActor(const UObject* OwnerObject)
+{
+	if (const auto* OwnerActor{ Cast<AActor>(OwnerObject) })
+	{
+		return OwnerActor;
+	}
+
+	if (const auto* OwnerComponent{ Cast<UActorComponent>(OwnerObject) })
+	{
+		return OwnerComponent->GetOwner();
+	}
+
+	return nullptr;
+}
+
+bool FGameplayTagStackOpsHelpers::IsOwningConnection(const UObject* OwnerObject, const FNetDeltaSerializeInfo& DeltaParms)
+{
+	auto* PackageMapClient{ Cast<UPackageMapClient>(DeltaParms.Map) };
+	auto* Connection{ PackageMapClient ? PackageMapClient->GetConnection() : nullptr };
+
+	if (!Connection)
+	{
+		return false;
+	}
+
+	const auto* OwnerActor{ GetOwnerActor(OwnerObject) };
+
+	return OwnerActor && (OwnerActor->GetNetConnection() == Connection);
+}
+
+double FGameplayTagStackOpsHelpers::GetServerTime(const UObject* OwnerObject)
+{
+	const auto* World{ OwnerObject ? OwnerObject->GetWorld() : nullptr };
+
+	if (!World)
+	{
+		return 0.0;
+	}
+
+	const auto* GameState{ World->GetGameState() };
+
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+bool FGameplayTagStackOpsHelpers::HasReplicationPolicies()
+{
+	return !GetDefault<UGameFrameworkDeveloperSettings>()->TagStackReplicationPolicies.IsEmpty();
+}
+
+uint32 FGameplayTagStackOpsHelpers::GetReplicationPoliciesRevision()
+{
+	return GetDefault<UGameFrameworkDeveloperSettings>()->GetTagStackReplicationPoliciesRevision();
+}
+
+EGameplayTagStackReplicationPolicy FGameplayTagStackOpsHelpers::ResolveReplicationPolicy(FGameplayTag Tag)
+{
+	return GetDefault<UGameFrameworkDeveloperSettings>()->GetTagStackReplicationPolicy(Tag);
+}
+
+#pragma endregion
@@ -0,0 +1,1606 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "GameplayTag/GameplayTagStack.h"
+
+#include "Message/GameplayMessageSubsystem.h"
+#include "GFCoreLogs.h"
+
+#include "GameFramework/Actor.h"
+#include "UObject/CoreNet.h"
+#include "Stats/Stats.h"
+
+
+DECLARE_STATS_GROUP(TEXT("GameplayTagStack"), STATGROUP_GameplayTagStack, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Mutations"), STAT_GameplayTagStack_NumMutations, STATGROUP_GameplayTagStack, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Elided Mutations"), STAT_GameplayTagStack_NumElidedMutations, STATGROUP_GameplayTagStack, );
+
+
+/**
+ * Engine queries used by TGameplayTagStackOps that do not depend on the value type
+ */
+struct FGameplayTagStackOpsHelpers
+{
+public:
+	/**
+	 * Returns the actor of the owner of a container (the owner itself or the owner of the component)
+	 */
+	static const AActor* GetOwnerActor(const UObject* OwnerObject);
+
+	/**
+	 * Returns whether the connection being serialized owns the actor of the owner of a container
+	 */
+	static bool IsOwningConnection(const UObject* OwnerObject, const FNetDeltaSerializeInfo& DeltaParms);
+
+	/**
+	 * Returns the server time used to evaluate the rates of the stacks owned by the object
+	 */
+	static double GetServerTime(const UObject* OwnerObject);
+
+	/**
+	 * Returns whether any replication policy is set in the developer settings
+	 */
+	static bool HasReplicationPolicies();
+
+	/**
+	 * Returns the revision of the replication policies in the developer settings
+	 */
+	static uint32 GetReplicationPoliciesRevision();
+
+	/**
+	 * Returns the replication policy of the tag in the developer settings
+	 */
+	static EGameplayTagStackReplicationPolicy ResolveReplicationPolicy(FGameplayTag Tag);
+};
+
+
+/**
+ * Replication state of a TagStack container for a connection
+ * 
+ * Tips:
+ *	Holds the fast array state of the items together with the acknowledgement last written before them,
+ *	so that the acknowledgement is only written again when it changes for the connection.
+ */
+struct FGameplayTagStackDeltaState : public INetDeltaBaseState
+{
+public:
+	//
+	// Fast array state of the items (null until the items are written for the first time)
+	//
+	TSharedPtr<INetDeltaBaseState> ArrayState;
+
+	//
+	// Latest prediction ID acknowledged to the connection (always 0 for connections that do not own the container)
+	//
+	int32 AcknowledgedPredictionId{ 0 };
+
+public:
+	virtual bool IsStateEqual(INetDeltaBaseState* OtherState) override
+	{
+		const auto* Other{ static_cast<FGameplayTagStackDeltaState*>(OtherState) };
+
+		if (AcknowledgedPredictionId != Other->AcknowledgedPredictionId)
+		{
+			return false;
+		}
+
+		if (!ArrayState.IsValid() || !Other->ArrayState.IsValid())
+		{
+			return ArrayState.IsValid() == Other->ArrayState.IsValid();
+		}
+
+		return ArrayState->IsStateEqual(Other->ArrayState.Get());
+	}
+
+	virtual void CountBytes(FArchive& Ar) const override
+	{
+		Ar.CountBytes(sizeof(*this), sizeof(*this));
+
+		if (ArrayState.IsValid())
+		{
+			ArrayState->CountBytes(Ar);
+		}
+	}
+};
+
+
+/**
+ * Mutation, lookup, batching, aggregate, snapshot, replication and prediction logic shared by the TagStack containers
+ * 
+ * Tips:
+ *	USTRUCTs cannot be templates, so each container declares its members and forwards to these functions.
+ *	The value type is chosen by the container type at compile time, so there is no runtime type dispatch.
+ *	ContainerType must define FItem, FFastStack, FValue, FDelta, FMessage and bHasRate,
+ *	have Stacks, FastStacks, FlatStacks, OwnerObject, MessagePolicy, LastAcknowledgedPredictionId and State,
+ *	and implement GetMessageChannel and MakeChangeMessage.
+ *	Aggregates and predictions use the stored value of stacks with a rate, not the value evaluated at the server time.
+ *	Snapshots store it too, but evaluate the rate when read.
+ */
+template<typename ContainerType>
+struct TGameplayTagStackOps
+{
+public:
+	using FItem = typename ContainerType::FItem;
+	using FFastStack = typename ContainerType::FFastStack;
+	using FValue = typename ContainerType::FValue;
+	using FDelta = typename ContainerType::FDelta;
+	using FMessage = typename ContainerType::FMessage;
+	using FTraits = TGameplayTagValueStackTraits<FValue>;
+	using FSum = typename FTraits::FSum;
+	using FAggregate = TGameplayTagStackAggregate<FValue>;
+	using FSnapshot = TGameplayTagStackSnapshot<FFastStack>;
+	using FBatchScope = TGameplayTagStackBatchScope<ContainerType>;
+
+	static constexpr bool bHasRate{ ContainerType::bHasRate };
+
+
+	///////////////////////////////////////////////////////////
+	// Validation
+public:
+	/**
+	 * Returns whether the tag can be used, logging the function that received it if not
+	 */
+	static bool CheckTag(FGameplayTag Tag, const TCHAR* FunctionName)
+	{
+		if (Tag.IsValid())
+		{
+			return true;
+		}
+
+		UE_LOG(LogGameCore_Framework, Warning, TEXT("An invalid tag was passed to %s"), FunctionName);
+
+		return false;
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Lookup
+public:
+	static FFastStack* FindFastStack(ContainerType& Container, FGameplayTag Tag)
+	{
+		return (Container.State.LookupMode == EGameplayTagStackLookupMode::FlatArray) ? Container.FlatStacks.Find(Tag) : Container.FastStacks.Find(Tag);
+	}
+
+	static const FFastStack* FindFastStack(const ContainerType& Container, FGameplayTag Tag)
+	{
+		return (Container.State.LookupMode == EGameplayTagStackLookupMode::FlatArray) ? Container.FlatStacks.Find(Tag) : Container.FastStacks.Find(Tag);
+	}
+
+	static FFastStack& FindOrAddFastStack(ContainerType& Container, FGameplayTag Tag)
+	{
+		return (Container.State.LookupMode == EGameplayTagStackLookupMode::FlatArray) ? Container.FlatStacks.FindOrAdd(Tag) : Container.FastStacks.FindOrAdd(Tag);
+	}
+
+	static void RemoveFastStack(ContainerType& Container, FGameplayTag Tag)
+	{
+		if (Container.State.LookupMode == EGameplayTagStackLookupMode::FlatArray)
+		{
+			Container.FlatStacks.Remove(Tag);
+		}
+		else
+		{
+			Container.FastStacks.Remove(Tag);
+		}
+	}
+
+	static void SetLookupMode(ContainerType& Container, EGameplayTagStackLookupMode NewLookupMode)
+	{
+		if (Container.State.LookupMode == NewLookupMode)
+		{
+			return;
+		}
+
+		if (NewLookupMode == EGameplayTagStackLookupMode::FlatArray)
+		{
+			for (const auto& KVP : Container.FastStacks)
+			{
+				Container.FlatStacks.FindOrAdd(KVP.Key) = KVP.Value;
+			}
+
+			Container.FastStacks.Empty();
+		}
+		else
+		{
+			for (const auto& Entry : Container.FlatStacks.GetEntries())
+			{
+				Container.FastStacks.Add(Entry.Key, Entry.Value);
+			}
+
+			Container.FlatStacks.Reset();
+		}
+
+		Container.State.LookupMode = NewLookupMode;
+	}
+
+	/**
+	 * Call the function for each tag and its FastStack entry regardless of the lookup mode
+	 */
+	template<typename FuncType>
+	static void ForEachFastStack(ContainerType& Container, FuncType&& Func)
+	{
+		if (Container.State.LookupMode == EGameplayTagStackLookupMode::FlatArray)
+		{
+			for (auto& Entry : Container.FlatStacks.GetEntries())
+			{
+				Func(Entry.Key, Entry.Value);
+			}
+		}
+		else
+		{
+			for (auto& KVP : Container.FastStacks)
+			{
+				Func(KVP.Key, KVP.Value);
+			}
+		}
+	}
+
+	/**
+	 * Call the function for each tag and its FastStack entry with the pending predictions applied to the value
+	 * 
+	 * Tips:
+	 *	Tags that only exist through a prediction are visited last.
+	 */
+	template<typename FuncType>
+	static void ForEachEffectiveStack(const ContainerType& Container, FuncType&& Func)
+	{
+		const auto& PredictedStacks{ Container.State.PredictedStacks };
+
+		const auto Visit
+		{
+			[&Container, &PredictedStacks, &Func](const FGameplayTag& Tag, const FFastStack& FastStack)
+			{
+				if (PredictedStacks.IsEmpty())
+				{
+					Func(Tag, FastStack);
+					return;
+				}
+
+				auto EffectiveStack{ FastStack };
+				EffectiveStack.Value = ApplyPredictedDeltas(Container, Tag, FastStack.Value, FastStack.MaxValue);
+
+				Func(Tag, EffectiveStack);
+			}
+		};
+
+		if (Container.State.LookupMode == EGameplayTagStackLookupMode::FlatArray)
+		{
+			for (const auto& Entry : Container.FlatStacks.GetEntries())
+			{
+				Visit(Entry.Key, Entry.Value);
+			}
+		}
+		else
+		{
+			for (const auto& KVP : Container.FastStacks)
+			{
+				Visit(KVP.Key, KVP.Value);
+			}
+		}
+
+		for (const auto& KVP : PredictedStacks)
+		{
+			if (!KVP.Value.Deltas.IsEmpty() && !FindFastStack(Container, KVP.Key))
+			{
+				FFastStack PredictedOnlyStack;
+				PredictedOnlyStack.Value = ApplyPredictedDeltas(Container, KVP.Key, FValue(0), FTraits::NoMax);
+
+				Func(KVP.Key, PredictedOnlyStack);
+			}
+		}
+	}
+
+	/**
+	 * Returns the index of the stack of the tag in Stacks (or INDEX_NONE if the tag is not present)
+	 */
+	static int32 FindStackIndex(ContainerType& Container, FGameplayTag Tag)
+	{
+		auto* FastStack{ FindFastStack(Container, Tag) };
+
+		if (!FastStack)
+		{
+			return INDEX_NONE;
+		}
+
+		// Rebuild indices if they are stale (e.g. after replicated removals reordered the array)
+
+		if (!Container.Stacks.IsValidIndex(FastStack->StackIndex) || (Container.Stacks[FastStack->StackIndex].Tag != Tag))
+		{
+			RebuildStackIndices(Container);
+		}
+
+		return FastStack->StackIndex;
+	}
+
+	/**
+	 * Rebuild the stack indices held by FastStacks from Stacks
+	 */
+	static void RebuildStackIndices(ContainerType& Container)
+	{
+		ForEachFastStack(Container,
+			[](const FGameplayTag&, FFastStack& FastStack)
+			{
+				FastStack.StackIndex = INDEX_NONE;
+			}
+		);
+
+		for (auto Index{ 0 }; Index < Container.Stacks.Num(); ++Index)
+		{
+			if (auto* FastStack{ FindFastStack(Container, Container.Stacks[Index].Tag) })
+			{
+				FastStack->StackIndex = Index;
+			}
+		}
+	}
+
+	/**
+	 * Returns the FastStack entry of the stack at the index
+	 */
+	static FFastStack MakeFastStack(const ContainerType& Container, int32 StackIndex)
+	{
+		const auto& Stack{ Container.Stacks[StackIndex] };
+
+		FFastStack FastStack;
+		FastStack.Value = Stack.*ContainerType::ItemValue;
+		FastStack.MaxValue = Stack.*ContainerType::ItemMaxValue;
+		FastStack.StackIndex = StackIndex;
+
+		if constexpr (bHasRate)
+		{
+			FastStack.Rate = Stack.Rate;
+			FastStack.RateStartTime = Stack.RateStartTime;
+		}
+
+		return FastStack;
+	}
+
+	/**
+	 * Returns whether the FastStack entries hold the same value
+	 */
+	static bool IsSameStack(const FFastStack& A, const FFastStack& B)
+	{
+		if constexpr (bHasRate)
+		{
+			if ((A.Rate != B.Rate) || (A.RateStartTime != B.RateStartTime))
+			{
+				return false;
+			}
+		}
+
+		return (A.Value == B.Value) && (A.MaxValue == B.MaxValue);
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Query
+public:
+	static double GetServerTime(const ContainerType& Container)
+	{
+		if constexpr (bHasRate)
+		{
+			return FGameplayTagStackOpsHelpers::GetServerTime(Container.OwnerObject);
+		}
+		else
+		{
+			return 0.0;
+		}
+	}
+
+	template<typename StackType>
+	static float GetRate(const StackType& Stack)
+	{
+		if constexpr (bHasRate)
+		{
+			return Stack.Rate;
+		}
+		else
+		{
+			return 0.0f;
+		}
+	}
+
+	/**
+	 * Returns the value of the stack at the server time (the stored value if it has no rate)
+	 */
+	template<typename StackType>
+	static FValue EvaluateValue(const StackType& Stack, double ServerTime)
+	{
+		if constexpr (bHasRate)
+		{
+			return FTraits::EvaluateValue(Stack, ServerTime);
+		}
+		else
+		{
+			return Stack.Value;
+		}
+	}
+
+	/**
+	 * Returns the current value of the tag with its pending predictions applied
+	 */
+	static FValue GetValue(const ContainerType& Container, FGameplayTag Tag)
+	{
+		const auto* FastStack{ FindFastStack(Container, Tag) };
+
+		auto Value{ FValue(0) };
+		auto MaxValue{ FTraits::NoMax };
+
+		if (FastStack)
+		{
+			Value = (GetRate(*FastStack) != 0.0f) ? EvaluateValue(*FastStack, GetServerTime(Container)) : FastStack->Value;
+			MaxValue = FastStack->MaxValue;
+		}
+
+		return Container.State.PredictedStacks.IsEmpty() ? Value : ApplyPredictedDeltas(Container, Tag, Value, MaxValue);
+	}
+
+	static FValue GetMaxValue(const ContainerType& Container, FGameplayTag Tag)
+	{
+		const auto* FastStack{ FindFastStack(Container, Tag) };
+		return FastStack ? FastStack->MaxValue : FTraits::NoMax;
+	}
+
+	static float GetRate(const ContainerType& Container, FGameplayTag Tag)
+	{
+		const auto* FastStack{ FindFastStack(Container, Tag) };
+		return FastStack ? GetRate(*FastStack) : 0.0f;
+	}
+
+	static bool ContainsTag(const ContainerType& Container, FGameplayTag Tag)
+	{
+		return FindFastStack(Container, Tag) != nullptr;
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Parent Aggregates
+public:
+	static void SetTrackParentAggregates(ContainerType& Container, bool bEnabled)
+	{
+		auto& State{ Container.State };
+
+		if (State.bTrackParentAggregates == bEnabled)
+		{
+			return;
+		}
+
+		State.bTrackParentAggregates = bEnabled;
+
+		State.ParentAggregates.Reset();
+
+		// Build aggregates from the current stacks
+
+		if (bEnabled)
+		{
+			ForEachEffectiveStack(Container,
+				[&Container](const FGameplayTag& Tag, const FFastStack& EffectiveStack)
+				{
+					UpdateParentAggregates(Container, Tag, false, FValue(0), true, EffectiveStack.Value);
+				}
+			);
+		}
+	}
+
+	/**
+	 * Apply the change of the value of the tag to the aggregates of the tag and all of its parents
+	 */
+	static void UpdateParentAggregates(ContainerType& Container, FGameplayTag Tag, bool bExisted, FValue OldValue, bool bExists, FValue NewValue)
+	{
+		const auto NewNonZero{ (bExists && (NewValue > FValue(0))) ? 1 : 0 };
+		const auto OldNonZero{ (bExisted && (OldValue > FValue(0))) ? 1 : 0 };
+
+		auto& ParentAggregates{ Container.State.ParentAggregates };
+
+		for (auto ParentTag{ Tag }; ParentTag.IsValid(); ParentTag = ParentTag.RequestDirectParent())
+		{
+			auto& Aggregate{ ParentAggregates.FindOrAdd(ParentTag) };
+
+			Aggregate.Sum += FSum(NewValue) - FSum(OldValue);
+			Aggregate.NumTags += int32(bExists) - int32(bExisted);
+			Aggregate.NumNonZeroTags += NewNonZero - OldNonZero;
+
+			if (Aggregate.NumTags <= 0)
+			{
+				ParentAggregates.Remove(ParentTag);
+				continue;
+			}
+
+			// Max can be raised incrementally, but needs recomputing when the current max decreases
+
+			if (bExists && (NewValue >= Aggregate.Max))
+			{
+				Aggregate.Max = NewValue;
+				Aggregate.bMaxDirty = false;
+			}
+			else if (bExisted && (OldValue == Aggregate.Max))
+			{
+				Aggregate.bMaxDirty = true;
+			}
+		}
+	}
+
+	/**
+	 * Apply the change of the value of the tag including its pending predictions to the aggregates
+	 * 
+	 * Tips:
+	 *	bExisted and OldValue are the values returned by GetEffectiveValue before the change.
+	 */
+	static void UpdateEffectiveAggregates(ContainerType& Container, FGameplayTag Tag, bool bExisted, FValue OldValue)
+	{
+		auto bExists{ false };
+		const auto NewValue{ GetEffectiveValue(Container, Tag, bExists) };
+
+		if (bExisted || bExists)
+		{
+			UpdateParentAggregates(Container, Tag, bExisted, OldValue, bExists, NewValue);
+		}
+	}
+
+	/**
+	 * Compute the aggregate of the parent tag by iterating over all tag stacks
+	 */
+	static FAggregate ComputeAggregate(const ContainerType& Container, FGameplayTag ParentTag)
+	{
+		FAggregate Aggregate;
+
+		ForEachEffectiveStack(Container,
+			[&Aggregate, &ParentTag](const FGameplayTag& Tag, const FFastStack& EffectiveStack)
+			{
+				if (Tag.MatchesTag(ParentTag))
+				{
+					Aggregate.Sum += FSum(EffectiveStack.Value);
+					Aggregate.Max = FMath::Max(Aggregate.Max, EffectiveStack.Value);
+					Aggregate.NumTags++;
+					Aggregate.NumNonZeroTags += (EffectiveStack.Value > FValue(0)) ? 1 : 0;
+				}
+			}
+		);
+
+		return Aggregate;
+	}
+
+	static FSum GetValueSum(const ContainerType& Container, FGameplayTag ParentTag)
+	{
+		if (Container.State.bTrackParentAggregates)
+		{
+			const auto* Aggregate{ Container.State.ParentAggregates.Find(ParentTag) };
+			return Aggregate ? Aggregate->Sum : FSum(0);
+		}
+
+		return ComputeAggregate(Container, ParentTag).Sum;
+	}
+
+	static FValue GetValueMax(const ContainerType& Container, FGameplayTag ParentTag)
+	{
+		if (Container.State.bTrackParentAggregates)
+		{
+			auto* Aggregate{ Container.State.ParentAggregates.Find(ParentTag) };
+
+			if (!Aggregate)
+			{
+				return FValue(0);
+			}
+
+			if (Aggregate->bMaxDirty)
+			{
+				Aggregate->Max = ComputeAggregate(Container, ParentTag).Max;
+				Aggregate->bMaxDirty = false;
+			}
+
+			return Aggregate->Max;
+		}
+
+		return ComputeAggregate(Container, ParentTag).Max;
+	}
+
+	static bool HasAnyValue(const ContainerType& Container, FGameplayTag ParentTag)
+	{
+		if (Container.State.bTrackParentAggregates)
+		{
+			const auto* Aggregate{ Container.State.ParentAggregates.Find(ParentTag) };
+			return Aggregate ? (Aggregate->NumNonZeroTags > 0) : false;
+		}
+
+		return ComputeAggregate(Container, ParentTag).NumNonZeroTags > 0;
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Snapshot
+public:
+	static void SetPublishSnapshots(ContainerType& Container, bool bEnabled)
+	{
+		auto& State{ Container.State };
+
+		if (State.bPublishSnapshots == bEnabled)
+		{
+			return;
+		}
+
+		State.bPublishSnapshots = bEnabled;
+
+		if (bEnabled)
+		{
+			PublishSnapshot(Container);
+		}
+		else
+		{
+			State.SnapshotPublisher.Reset();
+
+			State.bSnapshotDirty = false;
+		}
+	}
+
+	/**
+	 * Copy the current tag stacks into a new snapshot and publish it
+	 */
+	static void PublishSnapshot(ContainerType& Container)
+	{
+		auto& State{ Container.State };
+
+		auto NewSnapshot{ MakeShared<FSnapshot, ESPMode::ThreadSafe>() };
+
+		if ((State.LookupMode == EGameplayTagStackLookupMode::FlatArray) && State.PredictedStacks.IsEmpty())
+		{
+			NewSnapshot->Stacks = Container.FlatStacks;
+		}
+		else
+		{
+			// Readers see the same values as the container, including the pending predictions
+
+			NewSnapshot->Stacks.Reserve(Container.FastStacks.Num() + Container.FlatStacks.Num() + State.PredictedStacks.Num());
+
+			ForEachEffectiveStack(Container,
+				[&NewSnapshot](const FGameplayTag& Tag, const FFastStack& EffectiveStack)
+				{
+					NewSnapshot->Stacks.AddUnsorted(Tag, EffectiveStack);
+				}
+			);
+
+			NewSnapshot->Stacks.Sort();
+		}
+
+		if constexpr (bHasRate)
+		{
+			NewSnapshot->ServerTime = GetServerTime(Container);
+			NewSnapshot->PlatformTime = FPlatformTime::Seconds();
+		}
+
+		State.SnapshotPublisher.Publish(NewSnapshot);
+
+		State.bSnapshotDirty = false;
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Replication
+public:
+	static bool NetDeltaSerialize(ContainerType& Container, FNetDeltaSerializeInfo& DeltaParms)
+	{
+		auto& State{ Container.State };
+
+		// Resolve the owner only when writing, since stacks are filtered per connection
+
+		if (DeltaParms.Writer)
+		{
+			State.bIsSerializingForOwner = FGameplayTagStackOpsHelpers::IsOwningConnection(Container.OwnerObject, DeltaParms);
+
+			RefreshReplicationPolicies(Container);
+
+			return WriteDelta(Container, DeltaParms);
+		}
+
+		State.bIsSerializingForOwner = false;
+
+		if (DeltaParms.Reader)
+		{
+			return ReadDelta(Container, DeltaParms);
+		}
+
+		// Gathering and updating the object references of the items does not involve the acknowledgement
+
+		return FFastArraySerializer::FastArrayDeltaSerialize<FItem, ContainerType>(Container.Stacks, DeltaParms, Container);
+	}
+
+	/**
+	 * Writes the acknowledgement header followed by the changed items, and returns false if neither changed for the connection
+	 * 
+	 * Tips:
+	 *	The header is one bit when the acknowledgement is unchanged, so it costs nothing for connections that do not predict.
+	 */
+	static bool WriteDelta(ContainerType& Container, FNetDeltaSerializeInfo& DeltaParms)
+	{
+		auto& Writer{ *DeltaParms.Writer };
+
+		const auto* OldState{ static_cast<FGameplayTagStackDeltaState*>(DeltaParms.OldState) };
+
+		// Only the owning connection receives the acknowledgements, since only it predicts
+
+		const auto AcknowledgedPredictionId{ Container.State.bIsSerializingForOwner ? Container.LastAcknowledgedPredictionId : 0 };
+		const auto OldAcknowledgedPredictionId{ OldState ? OldState->AcknowledgedPredictionId : 0 };
+
+		// Items are written to a separate writer, since whether they changed is only known after writing them
+
+		FNetBitWriter ItemWriter(DeltaParms.Map, 0);
+		TSharedPtr<INetDeltaBaseState> NewArrayState;
+
+		auto ItemParms{ DeltaParms };
+		ItemParms.Writer = &ItemWriter;
+		ItemParms.OldState = OldState ? OldState->ArrayState.Get() : nullptr;
+		ItemParms.NewState = &NewArrayState;
+
+		const auto bItemsChanged{ FFastArraySerializer::FastArrayDeltaSerialize<FItem, ContainerType>(Container.Stacks, ItemParms, Container) };
+		uint8 bAcknowledgementChanged{ (AcknowledgedPredictionId != OldAcknowledgedPredictionId) ? uint8(1) : uint8(0) };
+
+		if (!bItemsChanged && !bAcknowledgementChanged)
+		{
+			return false;
+		}
+
+		Writer.SerializeBits(&bAcknowledgementChanged, 1);
+
+		if (bAcknowledgementChanged)
+		{
+			auto EncodedPredictionId{ uint32(AcknowledgedPredictionId) };
+			Writer.SerializeIntPacked(EncodedPredictionId);
+		}
+
+		uint8 bHasItems{ bItemsChanged ? uint8(1) : uint8(0) };
+		Writer.SerializeBits(&bHasItems, 1);
+
+		if (bHasItems)
+		{
+			Writer.SerializeBits(ItemWriter.GetData(), ItemWriter.GetNumBits());
+		}
+
+		// The items keep their previous state when only the acknowledgement was written
+
+		auto NewState{ MakeShared<FGameplayTagStackDeltaState>() };
+		NewState->AcknowledgedPredictionId = AcknowledgedPredictionId;
+
+		if (NewArrayState.IsValid())
+		{
+			NewState->ArrayState = NewArrayState;
+		}
+		else if (OldState)
+		{
+			NewState->ArrayState = OldState->ArrayState;
+		}
+
+		*DeltaParms.NewState = NewState;
+
+		return true;
+	}
+
+	/**
+	 * Reads the acknowledgement header and the items written by WriteDelta, then resolves the acknowledged predictions
+	 */
+	static bool ReadDelta(ContainerType& Container, FNetDeltaSerializeInfo& DeltaParms)
+	{
+		auto& Reader{ *DeltaParms.Reader };
+
+		uint8 bAcknowledgementChanged{ 0 };
+		Reader.SerializeBits(&bAcknowledgementChanged, 1);
+
+		if (bAcknowledgementChanged)
+		{
+			uint32 EncodedPredictionId{ 0 };
+			Reader.SerializeIntPacked(EncodedPredictionId);
+
+			Container.LastAcknowledgedPredictionId = int32(EncodedPredictionId);
+			Container.State.bAcknowledgementPending = true;
+		}
+
+		uint8 bHasItems{ 0 };
+		Reader.SerializeBits(&bHasItems, 1);
+
+		// Predictions are resolved in the batch of the replicated items when there are any, so that
+		// a prediction and the value that replaces it are broadcast as a single change
+
+		if (bHasItems && !FFastArraySerializer::FastArrayDeltaSerialize<FItem, ContainerType>(Container.Stacks, DeltaParms, Container))
+		{
+			return false;
+		}
+
+		ReceiveAcknowledgement(Container);
+
+		return !Reader.IsError();
+	}
+
+	/**
+	 * Filters the stacks by their replication policy for the connection currently being serialized
+	 */
+	static bool ShouldWriteItem(ContainerType& Container, const FItem& Item, bool bIsWritingOnClient)
+	{
+		if (bIsWritingOnClient)
+		{
+			return Item.ReplicationID != INDEX_NONE;
+		}
+
+		if (!Container.State.bHasReplicationPolicies)
+		{
+			return true;
+		}
+
+		switch (GetReplicationPolicy(Container, Item.Tag))
+		{
+		case EGameplayTagStackReplicationPolicy::ServerOnly:
+			return false;
+
+		case EGameplayTagStackReplicationPolicy::OwnerOnly:
+			return Container.State.bIsSerializingForOwner;
+
+		default:
+			return true;
+		}
+	}
+
+	/**
+	 * Returns the replication policy of the tag, resolving it from the developer settings on first use
+	 */
+	static EGameplayTagStackReplicationPolicy GetReplicationPolicy(ContainerType& Container, FGameplayTag Tag)
+	{
+		auto& ReplicationPolicies{ Container.State.ReplicationPolicies };
+
+		if (const auto* Policy{ ReplicationPolicies.Find(Tag) })
+		{
+			return *Policy;
+		}
+
+		return ReplicationPolicies.Add(Tag, FGameplayTagStackOpsHelpers::ResolveReplicationPolicy(Tag));
+	}
+
+	/**
+	 * Discard the cached replication policies if the policies in the developer settings have changed
+	 */
+	static void RefreshReplicationPolicies(ContainerType& Container)
+	{
+		auto& State{ Container.State };
+
+		State.bHasReplicationPolicies = FGameplayTagStackOpsHelpers::HasReplicationPolicies();
+
+		const auto Revision{ FGameplayTagStackOpsHelpers::GetReplicationPoliciesRevision() };
+
+		if (State.ReplicationPoliciesRevision != Revision)
+		{
+			State.ReplicationPoliciesRevision = Revision;
+			State.ReplicationPolicies.Reset();
+		}
+	}
+
+	static void PreReplicatedRemove(ContainerType& Container, const TArrayView<int32> RemovedIndices)
+	{
+		FBatchScope BatchScope(Container);
+
+		ReceiveAcknowledgement(Container);
+
+		for (const auto& Index : RemovedIndices)
+		{
+			const auto Tag{ Container.Stacks[Index].Tag };
+
+			if (!FindFastStack(Container, Tag))
+			{
+				CountElidedMutation(Container);
+
+				continue;
+			}
+
+			RefreshFastStacks(Container, Tag, nullptr);
+		}
+	}
+
+	static void PostReplicatedAddOrChange(ContainerType& Container, const TArrayView<int32> Indices)
+	{
+		FBatchScope BatchScope(Container);
+
+		ReceiveAcknowledgement(Container);
+
+		for (const auto& Index : Indices)
+		{
+			CommitReplicatedStack(Container, Index);
+		}
+	}
+
+	/**
+	 * Updates FastStacks from the replicated stack at the index and broadcasts messages only if its value changed
+	 */
+	static void CommitReplicatedStack(ContainerType& Container, int32 StackIndex)
+	{
+		const auto Tag{ Container.Stacks[StackIndex].Tag };
+
+		// Updates that only carry a new replication key leave the value as it was
+
+		const auto NewStack{ MakeFastStack(Container, StackIndex) };
+
+		auto* OldStack{ FindFastStack(Container, Tag) };
+
+		if (OldStack && IsSameStack(*OldStack, NewStack))
+		{
+			OldStack->StackIndex = StackIndex;
+
+			CountElidedMutation(Container);
+
+			return;
+		}
+
+		RefreshFastStacks(Container, Tag, &NewStack);
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Change and Notify
+public:
+	/**
+	 * Runs when a stack is changed (or removed if NewStack is null), updates FastStacks and the aggregates, and broadcasts messages
+	 */
+	static void RefreshFastStacks(ContainerType& Container, FGameplayTag Tag, const FFastStack* NewStack)
+	{
+		const auto bTrackParentAggregates{ Container.State.bTrackParentAggregates };
+
+		auto bExisted{ false };
+		const auto OldValue{ bTrackParentAggregates ? GetEffectiveValue(Container, Tag, bExisted) : FValue(0) };
+
+		if (NewStack)
+		{
+			FindOrAddFastStack(Container, Tag) = *NewStack;
+		}
+		else
+		{
+			RemoveFastStack(Container, Tag);
+		}
+
+		if (bTrackParentAggregates)
+		{
+			UpdateEffectiveAggregates(Container, Tag, bExisted, OldValue);
+		}
+
+		NotifyStackChanged(Container, Tag);
+	}
+
+	/**
+	 * Publish the snapshot and broadcast the current value of the tag, or defer them to the end of the batch
+	 */
+	static void NotifyStackChanged(ContainerType& Container, FGameplayTag Tag)
+	{
+		auto& State{ Container.State };
+
+		// Publish and broadcast once with the final value at the end of the batch
+
+		if (State.BatchDepth > 0)
+		{
+			State.PendingChangedTags.Add(Tag);
+
+			State.bSnapshotDirty = State.bPublishSnapshots;
+
+			return;
+		}
+
+		if (State.bPublishSnapshots)
+		{
+			PublishSnapshot(Container);
+		}
+
+		BroadcastChangeMessage(Container, Tag);
+	}
+
+	/**
+	 * Broadcast a message with the current value of the tag through the GameplayMessageSubsystem
+	 * 
+	 * Tips:
+	 *	Messages are keyed by the owner and tag, so listeners registered with RegisterListener only receive their own changes.
+	 */
+	static void BroadcastChangeMessage(ContainerType& Container, FGameplayTag Tag)
+	{
+		const auto* FastStack{ FindFastStack(Container, Tag) };
+
+		auto Value{ FastStack ? FastStack->Value : FValue(0) };
+		const auto MaxValue{ FastStack ? FastStack->MaxValue : FTraits::NoMax };
+		const auto Rate{ FastStack ? GetRate(*FastStack) : 0.0f };
+
+		// Broadcast the predicted value, and skip it if the listeners already received it
+
+		auto& PredictedStacks{ Container.State.PredictedStacks };
+
+		if (auto* PredictedStack{ PredictedStacks.Find(Tag) })
+		{
+			Value = ApplyPredictedDeltas(Container, Tag, Value, MaxValue);
+
+			const auto bAlreadyBroadcast{ (PredictedStack->LastBroadcastValue == Value) && (PredictedStack->LastBroadcastMaxValue == MaxValue) };
+
+			PredictedStack->LastBroadcastValue = Value;
+			PredictedStack->LastBroadcastMaxValue = MaxValue;
+
+			if (PredictedStack->Deltas.IsEmpty())
+			{
+				PredictedStacks.Remove(Tag);
+			}
+
+			if (bAlreadyBroadcast)
+			{
+				return;
+			}
+		}
+
+		const auto Message{ Container.MakeChangeMessage(Tag, Value, MaxValue, Rate) };
+
+		auto& MessageSystem{ UGameplayMessageSubsystem::Get(Container.OwnerObject->GetWorld()) };
+
+		if (Container.MessagePolicy == EGameplayTagStackMessagePolicy::CoalescePerFrame)
+		{
+			MessageSystem.BroadcastMessageCoalesced(ContainerType::GetMessageChannel(), Container.OwnerObject, Tag, Message);
+		}
+		else
+		{
+			MessageSystem.BroadcastMessageKeyed(ContainerType::GetMessageChannel(), Container.OwnerObject, Tag, Message);
+		}
+	}
+
+	static FGameplayMessageListenerHandle RegisterListener(const ContainerType& Container, FGameplayTag Tag, TFunction<void(FGameplayTag, const FMessage&)>&& Callback)
+	{
+		if (!Container.OwnerObject)
+		{
+			UE_LOG(LogGameCore_Framework, Warning, TEXT("RegisterStackChangeListener was called on a TagStack container without an owner"));
+
+			return FGameplayMessageListenerHandle();
+		}
+
+		auto& MessageSystem{ UGameplayMessageSubsystem::Get(Container.OwnerObject->GetWorld()) };
+
+		return MessageSystem.template RegisterKeyedListener<FMessage>(ContainerType::GetMessageChannel(), Container.OwnerObject, Tag, MoveTemp(Callback));
+	}
+
+	/**
+	 * Mark the stack item dirty for replication, or defer it to the end of the batch
+	 */
+	static void MarkStackDirty(ContainerType& Container, FItem& Stack)
+	{
+		if (Container.State.BatchDepth > 0)
+		{
+			Container.State.PendingDirtyTags.Add(Stack.Tag);
+		}
+		else
+		{
+			Container.MarkItemDirty(Stack);
+		}
+	}
+
+	/**
+	 * Updates FastStacks, broadcasts messages and marks the item dirty only if the stack at the index differs from OldStack
+	 * 
+	 * Tips:
+	 *	Returns false (and counts the mutation as elided) if nothing changed.
+	 */
+	static bool CommitStackChange(ContainerType& Container, int32 StackIndex, const FFastStack& OldStack)
+	{
+		// Clamping may leave the stack as it was, in which case nothing is replicated or broadcast
+
+		const auto NewStack{ MakeFastStack(Container, StackIndex) };
+
+		if (IsSameStack(NewStack, OldStack))
+		{
+			CountElidedMutation(Container);
+
+			return false;
+		}
+
+		INC_DWORD_STAT(STAT_GameplayTagStack_NumMutations);
+
+		RefreshFastStacks(Container, Container.Stacks[StackIndex].Tag, &NewStack);
+
+		MarkStackDirty(Container, Container.Stacks[StackIndex]);
+
+		return true;
+	}
+
+	/**
+	 * Count a mutation that was skipped because it changed nothing
+	 */
+	static void CountElidedMutation(ContainerType& Container)
+	{
+		INC_DWORD_STAT(STAT_GameplayTagStack_NumElidedMutations);
+
+		++Container.State.NumElidedMutations;
+	}
+
+	/**
+	 * Add a new stack of the tag, updates FastStacks, and broadcasts messages
+	 */
+	static FValue AddNewStack(ContainerType& Container, FGameplayTag Tag, FValue Value, FValue MaxValue, float Rate = 0.0f)
+	{
+		const auto NewMaxValue{ FTraits::NormalizeMax(MaxValue) };
+		const auto NewIndex{ Container.Stacks.Emplace(Tag, FTraits::ClampValue(Value, NewMaxValue), NewMaxValue) };
+
+		if constexpr (bHasRate)
+		{
+			if (Rate != 0.0f)
+			{
+				Container.Stacks[NewIndex].Rate = Rate;
+				Container.Stacks[NewIndex].RateStartTime = GetServerTime(Container);
+			}
+		}
+
+		INC_DWORD_STAT(STAT_GameplayTagStack_NumMutations);
+
+		const auto NewStack{ MakeFastStack(Container, NewIndex) };
+
+		RefreshFastStacks(Container, Tag, &NewStack);
+
+		MarkStackDirty(Container, Container.Stacks[NewIndex]);
+
+		return NewStack.Value;
+	}
+
+	/**
+	 * Remove the stack at the index by swapping with the last one, updates FastStacks, and broadcasts messages
+	 */
+	static void RemoveStackAt(ContainerType& Container, int32 StackIndex)
+	{
+		const auto Tag{ Container.Stacks[StackIndex].Tag };
+
+		// Swap with the last element and fix up its index
+
+		Container.Stacks.RemoveAtSwap(StackIndex);
+
+		if (Container.Stacks.IsValidIndex(StackIndex))
+		{
+			if (auto* MovedFastStack{ FindFastStack(Container, Container.Stacks[StackIndex].Tag) })
+			{
+				MovedFastStack->StackIndex = StackIndex;
+			}
+		}
+
+		INC_DWORD_STAT(STAT_GameplayTagStack_NumMutations);
+
+		RefreshFastStacks(Container, Tag, nullptr);
+
+		Container.MarkArrayDirty();
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Batch
+public:
+	static void BeginBatch(ContainerType& Container)
+	{
+		++Container.State.BatchDepth;
+	}
+
+	static void EndBatch(ContainerType& Container)
+	{
+		auto& State{ Container.State };
+
+		check(State.BatchDepth > 0);
+
+		if (--State.BatchDepth > 0)
+		{
+			return;
+		}
+
+		// Mark each changed item dirty only once
+
+		if (!State.PendingDirtyTags.IsEmpty())
+		{
+			for (const auto& Tag : State.PendingDirtyTags)
+			{
+				const auto StackIndex{ FindStackIndex(Container, Tag) };
+
+				if (StackIndex != INDEX_NONE)
+				{
+					Container.MarkItemDirty(Container.Stacks[StackIndex]);
+				}
+			}
+
+			State.PendingDirtyTags.Reset();
+		}
+
+		// Publish the snapshot before the listeners are notified
+
+		if (State.bSnapshotDirty)
+		{
+			PublishSnapshot(Container);
+		}
+
+		// Broadcast the final value of each changed tag
+
+		if (!State.PendingChangedTags.IsEmpty())
+		{
+			// Move out in case the listeners modify the container
+
+			const auto ChangedTags{ MoveTemp(State.PendingChangedTags) };
+
+			for (const auto& Tag : ChangedTags)
+			{
+				BroadcastChangeMessage(Container, Tag);
+			}
+		}
+	}
+
+	/**
+	 * Apply the value changes of many tags in one pass over the stacks as a single batch
+	 */
+	static void ApplyDeltas(ContainerType& Container, TConstArrayView<FDelta> Deltas, bool bCanAddNewTag, bool bRemoveTagAtZero, const TCHAR* FunctionName)
+	{
+		FBatchScope BatchScope(Container);
+
+		// Sum deltas for the same tag
+
+		TMap<FGameplayTag, FValue> MergedDeltas;
+		MergedDeltas.Reserve(Deltas.Num());
+
+		for (const auto& Delta : Deltas)
+		{
+			if (CheckTag(Delta.Tag, FunctionName))
+			{
+				MergedDeltas.FindOrAdd(Delta.Tag) += Delta.Delta;
+			}
+		}
+
+		// Apply to each tag
+
+		for (const auto& KVP : MergedDeltas)
+		{
+			if (KVP.Value != FValue(0))
+			{
+				AddValue(Container, KVP.Key, KVP.Value, bCanAddNewTag, bRemoveTagAtZero);
+			}
+		}
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Mutation
+public:
+	/**
+	 * Set the value and max of the stack at the index (restarting the rate from the server time if it has one), then commit the change
+	 */
+	static FValue CommitValue(ContainerType& Container, int32 StackIndex, FValue NewValue, FValue NewMaxValue, float NewRate, double ServerTime)
+	{
+		const auto OldStack{ MakeFastStack(Container, StackIndex) };
+
+		auto& Stack{ Container.Stacks[StackIndex] };
+		Stack.*ContainerType::ItemValue = NewValue;
+		Stack.*ContainerType::ItemMaxValue = NewMaxValue;
+
+		if constexpr (bHasRate)
+		{
+			Stack.Rate = NewRate;
+			Stack.RateStartTime = (NewRate != 0.0f) ? ServerTime : 0.0;
+		}
+
+		CommitStackChange(Container, StackIndex, OldStack);
+
+		return NewValue;
+	}
+
+	static void SetMaxValue(ContainerType& Container, FGameplayTag Tag, FValue MaxValue, bool bCanAddNewTag)
+	{
+		const auto NewMaxValue{ FTraits::NormalizeMax(MaxValue) };
+		const auto StackIndex{ FindStackIndex(Container, Tag) };
+
+		if (StackIndex != INDEX_NONE)
+		{
+			const auto Stack{ MakeFastStack(Container, StackIndex) };
+
+			if (Stack.MaxValue == NewMaxValue)
+			{
+				CountElidedMutation(Container);
+
+				return;
+			}
+
+			const auto ServerTime{ GetServerTime(Container) };
+			const auto NewValue{ FTraits::ClampValue(EvaluateValue(Stack, ServerTime), NewMaxValue) };
+
+			CommitValue(Container, StackIndex, NewValue, NewMaxValue, GetRate(Stack), ServerTime);
+		}
+		else if (bCanAddNewTag)
+		{
+			AddNewStack(Container, Tag, FValue(0), NewMaxValue);
+		}
+	}
+
+	/**
+	 * Set the value of the tag
+	 * 
+	 * Tips:
+	 *	If bRemoveTagAtZero, a value of 0 or less removes the stack instead.
+	 */
+	static FValue SetValue(ContainerType& Container, FGameplayTag Tag, FValue Value, bool bCanAddNewTag, bool bRemoveTagAtZero)
+	{
+		const auto StackIndex{ FindStackIndex(Container, Tag) };
+
+		if (StackIndex != INDEX_NONE)
+		{
+			if (bRemoveTagAtZero && (Value <= FValue(0)))
+			{
+				RemoveStackAt(Container, StackIndex);
+
+				return FValue(0);
+			}
+
+			const auto Stack{ MakeFastStack(Container, StackIndex) };
+
+			const auto ServerTime{ GetServerTime(Container) };
+			const auto NewValue{ FTraits::ClampValue(Value, Stack.MaxValue) };
+
+			if (NewValue == EvaluateValue(Stack, ServerTime))
+			{
+				CountElidedMutation(Container);
+
+				return NewValue;
+			}
+
+			return CommitValue(Container, StackIndex, NewValue, Stack.MaxValue, GetRate(Stack), ServerTime);
+		}
+
+		if (bCanAddNewTag && !(bRemoveTagAtZero && (Value <= FValue(0))))
+		{
+			return AddNewStack(Container, Tag, Value, FTraits::NoMax);
+		}
+
+		return FValue(0);
+	}
+
+	/**
+	 * Add the delta to the value of the tag (subtracted if negative)
+	 * 
+	 * Tips:
+	 *	A new stack is only added for a delta of 0 or more.
+	 *	If bRemoveTagAtZero, the stack is removed when the value reaches 0.
+	 */
+	static FValue AddValue(ContainerType& Container, FGameplayTag Tag, FValue Delta, bool bCanAddNewTag, bool bRemoveTagAtZero)
+	{
+		const auto StackIndex{ FindStackIndex(Container, Tag) };
+
+		if (StackIndex != INDEX_NONE)
+		{
+			const auto Stack{ MakeFastStack(Container, StackIndex) };
+
+			const auto ServerTime{ GetServerTime(Container) };
+			const auto CurrentValue{ EvaluateValue(Stack, ServerTime) };
+			const auto NewValue{ FTraits::ClampValue(CurrentValue + Delta, Stack.MaxValue) };
+
+			if (bRemoveTagAtZero && (NewValue <= FValue(0)))
+			{
+				RemoveStackAt(Container, StackIndex);
+
+				return FValue(0);
+			}
+
+			if (NewValue == CurrentValue)
+			{
+				CountElidedMutation(Container);
+
+				return CurrentValue;
+			}
+
+			return CommitValue(Container, StackIndex, NewValue, Stack.MaxValue, GetRate(Stack), ServerTime);
+		}
+
+		if (bCanAddNewTag && (Delta >= FValue(0)))
+		{
+			return AddNewStack(Container, Tag, Delta, FTraits::NoMax);
+		}
+
+		return FValue(0);
+	}
+
+	/**
+	 * Set the change of the value per second of the tag, fixing the value reached with the old rate
+	 */
+	static void SetRate(ContainerType& Container, FGameplayTag Tag, float Rate, bool bCanAddNewTag)
+	{
+		static_assert(bHasRate, "SetRate requires a container whose stacks have a rate");
+
+		const auto StackIndex{ FindStackIndex(Container, Tag) };
+
+		if (StackIndex != INDEX_NONE)
+		{
+			const auto Stack{ MakeFastStack(Container, StackIndex) };
+
+			if (Stack.Rate == Rate)
+			{
+				CountElidedMutation(Container);
+
+				return;
+			}
+
+			// Fix the value reached with the old rate and restart from now with the new rate
+
+			const auto ServerTime{ GetServerTime(Container) };
+
+			CommitValue(Container, StackIndex, EvaluateValue(Stack, ServerTime), Stack.MaxValue, Rate, ServerTime);
+		}
+		else if (bCanAddNewTag && (Rate != 0.0f))
+		{
+			AddNewStack(Container, Tag, FValue(0), FTraits::NoMax, Rate);
+		}
+	}
+
+
+	///////////////////////////////////////////////////////////
+	// Prediction
+public:
+	static void PredictValue(ContainerType& Container, FGameplayTag Tag, FValue Delta, int32 PredictionId, const TCHAR* FunctionName)
+	{
+		if (!Tag.IsValid() || (Delta == FValue(0)))
+		{
+			return;
+		}
+
+		// The server applies the change itself, so there is nothing to predict
+
+		const auto* OwnerActor{ FGameplayTagStackOpsHelpers::GetOwnerActor(Container.OwnerObject) };
+
+		if (OwnerActor && OwnerActor->HasAuthority())
+		{
+			UE_LOG(LogGameCore_Framework, Verbose, TEXT("%s was called with authority on %s and was ignored"), FunctionName, *GetNameSafe(OwnerActor));
+
+			return;
+		}
+
+		auto bExisted{ false };
+		const auto OldValue{ GetEffectiveValue(Container, Tag, bExisted) };
+
+		auto& PredictedStacks{ Container.State.PredictedStacks };
+		auto* PredictedStack{ PredictedStacks.Find(Tag) };
+
+		if (!PredictedStack)
+		{
+			PredictedStack = &PredictedStacks.Add(Tag);
+			PredictedStack->LastBroadcastValue = OldValue;
+			PredictedStack->LastBroadcastMaxValue = GetMaxValue(Container, Tag);
+		}
+
+		PredictedStack->Deltas.Emplace(PredictionId, Delta);
+
+		if (Container.State.bTrackParentAggregates)
+		{
+			UpdateEffectiveAggregates(Container, Tag, bExisted, OldValue);
+		}
+
+		NotifyStackChanged(Container, Tag);
+	}
+
+	static void AcknowledgePrediction(ContainerType& Container, int32 PredictionId)
+	{
+		if (PredictionId <= Container.LastAcknowledgedPredictionId)
+		{
+			CountElidedMutation(Container);
+
+			return;
+		}
+
+		// Written to the owning connection by the next NetDeltaSerialize, without marking any item dirty
+
+		Container.LastAcknowledgedPredictionId = PredictionId;
+	}
+
+	static void ClearPredictions(ContainerType& Container)
+	{
+		auto& State{ Container.State };
+
+		if (State.PredictedStacks.IsEmpty())
+		{
+			return;
+		}
+
+		FBatchScope BatchScope(Container);
+
+		for (auto& KVP : State.PredictedStacks)
+		{
+			auto bExisted{ false };
+			const auto OldValue{ GetEffectiveValue(Container, KVP.Key, bExisted) };
+
+			KVP.Value.Deltas.Reset();
+
+			if (State.bTrackParentAggregates)
+			{
+				UpdateEffectiveAggregates(Container, KVP.Key, bExisted, OldValue);
+			}
+
+			NotifyStackChanged(Container, KVP.Key);
+		}
+	}
+
+	static bool HasPendingPrediction(const ContainerType& Container, FGameplayTag Tag)
+	{
+		const auto* PredictedStack{ Container.State.PredictedStacks.Find(Tag) };
+		return PredictedStack && !PredictedStack->Deltas.IsEmpty();
+	}
+
+	/**
+	 * Apply the pending predicted deltas of the tag to the replicated value
+	 */
+	static FValue ApplyPredictedDeltas(const ContainerType& Container, FGameplayTag Tag, FValue Value, FValue MaxValue)
+	{
+		const auto* PredictedStack{ Container.State.PredictedStacks.Find(Tag) };
+
+		if (!PredictedStack)
+		{
+			return Value;
+		}
+
+		for (const auto& Delta : PredictedStack->Deltas)
+		{
+			Value = FTraits::ClampValue(Value + Delta.Value, MaxValue);
+		}
+
+		return Value;
+	}
+
+	/**
+	 * Returns the stored value of the tag with its pending predictions applied, and whether the tag is present or predicted
+	 */
+	static FValue GetEffectiveValue(const ContainerType& Container, FGameplayTag Tag, bool& bOutExists)
+	{
+		const auto* FastStack{ FindFastStack(Container, Tag) };
+		const auto Value{ FastStack ? FastStack->Value : FValue(0) };
+		const auto bPredicted{ HasPendingPrediction(Container, Tag) };
+
+		bOutExists = (FastStack != nullptr) || bPredicted;
+
+		return bPredicted ? ApplyPredictedDeltas(Container, Tag, Value, FastStack ? FastStack->MaxValue : FTraits::NoMax) : Value;
+	}
+
+	/**
+	 * Resolve the predictions covered by the acknowledgement received by ReadDelta (client only)
+	 */
+	static void ReceiveAcknowledgement(ContainerType& Container)
+	{
+		auto& State{ Container.State };
+
+		if (!State.bAcknowledgementPending)
+		{
+			return;
+		}
+
+		State.bAcknowledgementPending = false;
+
+		ResolvePredictions(Container, Container.LastAcknowledgedPredictionId);
+	}
+
+	/**
+	 * Discard the predictions of all tags up to the acknowledged prediction ID
+	 */
+	static void ResolvePredictions(ContainerType& Container, int32 AcknowledgedPredictionId)
+	{
+		auto& State{ Container.State };
+
+		if (State.PredictedStacks.IsEmpty() || (AcknowledgedPredictionId == 0))
+		{
+			return;
+		}
+
+		// Broadcasts are deferred so that entries are not removed from PredictedStacks while iterating it
+
+		FBatchScope BatchScope(Container);
+
+		// The server acknowledges the predictions of the container in order, regardless of their tags
+
+		for (auto& KVP : State.PredictedStacks)
+		{
+			auto bExisted{ false };
+			const auto OldValue{ GetEffectiveValue(Container, KVP.Key, bExisted) };
+
+			const auto NumRemoved{ KVP.Value.Deltas.RemoveAll(
+				[AcknowledgedPredictionId](const TPair<int32, FValue>& Delta)
+				{
+					return Delta.Key <= AcknowledgedPredictionId;
+				}
+			) };
+
+			if (NumRemoved > 0)
+			{
+				if (State.bTrackParentAggregates)
+				{
+					UpdateEffectiveAggregates(Container, KVP.Key, bExisted, OldValue);
+				}
+
+				NotifyStackChanged(Container, KVP.Key);
+			}
+		}
+	}
+
+};
@@ -0,0 +1,24 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "UObject/ObjectMacros.h"
+
+#include "GameplayTagStackReplicationPolicy.generated.h"
+
+
+/**
+ * Which connections the tag stack is replicated to
+ */
+UENUM(BlueprintType)
+enum class EGameplayTagStackReplicationPolicy : uint8
+{
+	// Replicated to all connections
+	All,
+
+	// Replicated only to the connection that owns the container's actor
+	OwnerOnly,
+
+	// Never replicated
+	ServerOnly
+};
@@ -0,0 +1,438 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GameplayTagValueStack.h"
+
+#include "GameplayTag/GameplayTagStackOps.h"
+#include "GameplayTag/GameplayTagStackMessageTypes.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GameplayTagValueStack)
+
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayTagInt64Stack
+
+#pragma region FGameplayTagInt64Stack
+
+FString FGameplayTagInt64Stack::GetDebugString() const
+{
+	return FString::Printf(TEXT("%s(%lld/%lld)"), *Tag.ToString(), Value, MaxValue);
+}
+
+bool FGameplayTagInt64Stack::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	auto bTagSuccess{ true };
+	Tag.NetSerialize(Ar, Map, bTagSuccess);
+
+	auto EncodedValue{ (uint64(Value) << 1) ^ uint64(Value >> 63) };
+	Ar.SerializeIntPacked64(EncodedValue);
+
+	uint8 bHasMaxValue{ (MaxValue != -1) ? uint8(1) : uint8(0) };
+	Ar.SerializeBits(&bHasMaxValue, 1);
+
+	auto EncodedMaxValue{ bHasMaxValue ? uint64(MaxValue) : uint64(0) };
+	if (bHasMaxValue)
+	{
+		Ar.SerializeIntPacked64(EncodedMaxValue);
+	}
+
+	if (Ar.IsLoading())
+	{
+		Value = int64(EncodedValue >> 1) ^ -int64(EncodedValue & 1);
+		MaxValue = bHasMaxValue ? int64(EncodedMaxValue) : -1;
+	}
+
+	uint8 bHasRate{ (Rate != 0.0f) ? uint8(1) : uint8(0) };
+	Ar.SerializeBits(&bHasRate, 1);
+
+	if (bHasRate)
+	{
+		Ar << Rate;
+		Ar << RateStartTime;
+	}
+	else if (Ar.IsLoading())
+	{
+		Rate = 0.0f;
+		RateStartTime = 0.0;
+	}
+
+	bOutSuccess = bTagSuccess && !Ar.IsError();
+
+	return true;
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayTagFloatStack
+
+#pragma region FGameplayTagFloatStack
+
+FString FGameplayTagFloatStack::GetDebugString() const
+{
+	return FString::Printf(TEXT("%s(%f/%f)"), *Tag.ToString(), Value, MaxValue);
+}
+
+bool FGameplayTagFloatStack::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	auto bTagSuccess{ true };
+	Tag.NetSerialize(Ar, Map, bTagSuccess);
+
+	Ar << Value;
+
+	uint8 bHasMaxValue{ (MaxValue != -1.0f) ? uint8(1) : uint8(0) };
+	Ar.SerializeBits(&bHasMaxValue, 1);
+
+	if (bHasMaxValue)
+	{
+		Ar << MaxValue;
+	}
+	else if (Ar.IsLoading())
+	{
+		MaxValue = -1.0f;
+	}
+
+	uint8 bHasRate{ (Rate != 0.0f) ? uint8(1) : uint8(0) };
+	Ar.SerializeBits(&bHasRate, 1);
+
+	if (bHasRate)
+	{
+		Ar << Rate;
+		Ar << RateStartTime;
+	}
+	else if (Ar.IsLoading())
+	{
+		Rate = 0.0f;
+		RateStartTime = 0.0;
+	}
+
+	bOutSuccess = bTagSuccess && !Ar.IsError();
+
+	return true;
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayTagInt64StackContainer
+
+#pragma region FGameplayTagInt64StackContainer
+
+void FGameplayTagInt64StackContainer::SetLookupMode(EGameplayTagStackLookupMode NewLookupMode)
+{
+	FOps::SetLookupMode(*this, NewLookupMode);
+}
+
+void FGameplayTagInt64StackContainer::SetTrackParentAggregates(bool bEnabled)
+{
+	FOps::SetTrackParentAggregates(*this, bEnabled);
+}
+
+void FGameplayTagInt64StackContainer::SetPublishSnapshots(bool bEnabled)
+{
+	FOps::SetPublishSnapshots(*this, bEnabled);
+}
+
+
+void FGameplayTagInt64StackContainer::PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize)
+{
+	FOps::PreReplicatedRemove(*this, RemovedIndices);
+}
+
+void FGameplayTagInt64StackContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
+{
+	FOps::PostReplicatedAddOrChange(*this, AddedIndices);
+}
+
+void FGameplayTagInt64StackContainer::PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize)
+{
+	FOps::PostReplicatedAddOrChange(*this, ChangedIndices);
+}
+
+bool FGameplayTagInt64StackContainer::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	return FOps::NetDeltaSerialize(*this, DeltaParms);
+}
+
+
+FGameplayMessageListenerHandle FGameplayTagInt64StackContainer::RegisterStackChangeListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagInt64StackChangeMessage&)>&& Callback) const
+{
+	return FOps::RegisterListener(*this, Tag, MoveTemp(Callback));
+}
+
+FGameplayTag FGameplayTagInt64StackContainer::GetMessageChannel()
+{
+	return TAG_Message_TagStackInt64Change;
+}
+
+FGameplayTagInt64StackChangeMessage FGameplayTagInt64StackContainer::MakeChangeMessage(FGameplayTag Tag, int64 Value, int64 MaxValue, float Rate) const
+{
+	FGameplayTagInt64StackChangeMessage Message;
+	Message.OwningObject = OwnerObject;
+	Message.Tag = Tag;
+	Message.Value = Value;
+	Message.MaxValue = MaxValue;
+	Message.Rate = Rate;
+
+	return Message;
+}
+
+
+void FGameplayTagInt64StackContainer::PredictValue(FGameplayTag Tag, int64 Delta, int32 PredictionId)
+{
+	FOps::PredictValue(*this, Tag, Delta, PredictionId, TEXT("PredictValue"));
+}
+
+void FGameplayTagInt64StackContainer::AcknowledgePrediction(int32 PredictionId)
+{
+	FOps::AcknowledgePrediction(*this, PredictionId);
+}
+
+void FGameplayTagInt64StackContainer::ClearPredictions()
+{
+	FOps::ClearPredictions(*this);
+}
+
+
+void FGameplayTagInt64StackContainer::BeginBatch()
+{
+	FOps::BeginBatch(*this);
+}
+
+void FGameplayTagInt64StackContainer::EndBatch()
+{
+	FOps::EndBatch(*this);
+}
+
+void FGameplayTagInt64StackContainer::ApplyValueDeltas(TConstArrayView<FGameplayTagInt64StackDelta> Deltas, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	FOps::ApplyDeltas(*this, Deltas, bCanAddNewTag, bRemoveTagAtZero, TEXT("ApplyValueDeltas"));
+}
+
+
+void FGameplayTagInt64StackContainer::SetMaxValue(FGameplayTag Tag, int64 MaxValue, bool bCanAddNewTag)
+{
+	if (FOps::CheckTag(Tag, TEXT("SetMaxValue")))
+	{
+		FOps::SetMaxValue(*this, Tag, MaxValue, bCanAddNewTag);
+	}
+}
+
+int64 FGameplayTagInt64StackContainer::SetValue(FGameplayTag Tag, int64 Value, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	return FOps::CheckTag(Tag, TEXT("SetValue")) ? FOps::SetValue(*this, Tag, Value, bCanAddNewTag, bRemoveTagAtZero) : 0;
+}
+
+int64 FGameplayTagInt64StackContainer::AddValue(FGameplayTag Tag, int64 Delta, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	return FOps::CheckTag(Tag, TEXT("AddValue")) ? FOps::AddValue(*this, Tag, Delta, bCanAddNewTag, bRemoveTagAtZero) : 0;
+}
+
+void FGameplayTagInt64StackContainer::SetRate(FGameplayTag Tag, float Rate, bool bCanAddNewTag)
+{
+	if (FOps::CheckTag(Tag, TEXT("SetRate")))
+	{
+		FOps::SetRate(*this, Tag, Rate, bCanAddNewTag);
+	}
+}
+
+
+int64 FGameplayTagInt64StackContainer::GetValue(FGameplayTag Tag) const
+{
+	return FOps::GetValue(*this, Tag);
+}
+
+int64 FGameplayTagInt64StackContainer::GetMaxValue(FGameplayTag Tag) const
+{
+	return FOps::GetMaxValue(*this, Tag);
+}
+
+float FGameplayTagInt64StackContainer::GetRate(FGameplayTag Tag) const
+{
+	return FOps::GetRate(*this, Tag);
+}
+
+bool FGameplayTagInt64StackContainer::ContainsTag(FGameplayTag Tag) const
+{
+	return FOps::ContainsTag(*this, Tag);
+}
+
+int64 FGameplayTagInt64StackContainer::GetValueSum(FGameplayTag ParentTag) const
+{
+	return FOps::GetValueSum(*this, ParentTag);
+}
+
+int64 FGameplayTagInt64StackContainer::GetValueMax(FGameplayTag ParentTag) const
+{
+	return FOps::GetValueMax(*this, ParentTag);
+}
+
+bool FGameplayTagInt64StackContainer::HasAnyValue(FGameplayTag ParentTag) const
+{
+	return FOps::HasAnyValue(*this, ParentTag);
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayTagFloatStackContainer
+
+#pragma region FGameplayTagFloatStackContainer
+
+void FGameplayTagFloatStackContainer::SetLookupMode(EGameplayTagStackLookupMode NewLookupMode)
+{
+	FOps::SetLookupMode(*this, NewLookupMode);
+}
+
+void FGameplayTagFloatStackContainer::SetTrackParentAggregates(bool bEnabled)
+{
+	FOps::SetTrackParentAggregates(*this, bEnabled);
+}
+
+void FGameplayTagFloatStackContainer::SetPublishSnapshots(bool bEnabled)
+{
+	FOps::SetPublishSnapshots(*this, bEnabled);
+}
+
+
+void FGameplayTagFloatStackContainer::PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize)
+{
+	FOps::PreReplicatedRemove(*this, RemovedIndices);
+}
+
+void FGameplayTagFloatStackContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
+{
+	FOps::PostReplicatedAddOrChange(*this, AddedIndices);
+}
+
+void FGameplayTagFloatStackContainer::PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize)
+{
+	FOps::PostReplicatedAddOrChange(*this, ChangedIndices);
+}
+
+bool FGameplayTagFloatStackContainer::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	return FOps::NetDeltaSerialize(*this, DeltaParms);
+}
+
+
+FGameplayMessageListenerHandle FGameplayTagFloatStackContainer::RegisterStackChangeListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagFloatStackChangeMessage&)>&& Callback) const
+{
+	return FOps::RegisterListener(*this, Tag, MoveTemp(Callback));
+}
+
+FGameplayTag FGameplayTagFloatStackContainer::GetMessageChannel()
+{
+	return TAG_Message_TagStackFloatChange;
+}
+
+FGameplayTagFloatStackChangeMessage FGameplayTagFloatStackContainer::MakeChangeMessage(FGameplayTag Tag, float Value, float MaxValue, float Rate) const
+{
+	FGameplayTagFloatStackChangeMessage Message;
+	Message.OwningObject = OwnerObject;
+	Message.Tag = Tag;
+	Message.Value = Value;
+	Message.MaxValue = MaxValue;
+	Message.Rate = Rate;
+
+	return Message;
+}
+
+
+void FGameplayTagFloatStackContainer::PredictValue(FGameplayTag Tag, float Delta, int32 PredictionId)
+{
+	FOps::PredictValue(*this, Tag, Delta, PredictionId, TEXT("PredictValue"));
+}
+
+void FGameplayTagFloatStackContainer::AcknowledgePrediction(int32 PredictionId)
+{
+	FOps::AcknowledgePrediction(*this, PredictionId);
+}
+
+void FGameplayTagFloatStackContainer::ClearPredictions()
+{
+	FOps::ClearPredictions(*this);
+}
+
+
+void FGameplayTagFloatStackContainer::BeginBatch()
+{
+	FOps::BeginBatch(*this);
+}
+
+void FGameplayTagFloatStackContainer::EndBatch()
+{
+	FOps::EndBatch(*this);
+}
+
+void FGameplayTagFloatStackContainer::ApplyValueDeltas(TConstArrayView<FGameplayTagFloatStackDelta> Deltas, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	FOps::ApplyDeltas(*this, Deltas, bCanAddNewTag, bRemoveTagAtZero, TEXT("ApplyValueDeltas"));
+}
+
+
+void FGameplayTagFloatStackContainer::SetMaxValue(FGameplayTag Tag, float MaxValue, bool bCanAddNewTag)
+{
+	if (FOps::CheckTag(Tag, TEXT("SetMaxValue")))
+	{
+		FOps::SetMaxValue(*this, Tag, MaxValue, bCanAddNewTag);
+	}
+}
+
+float FGameplayTagFloatStackContainer::SetValue(FGameplayTag Tag, float Value, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	return FOps::CheckTag(Tag, TEXT("SetValue")) ? FOps::SetValue(*this, Tag, Value, bCanAddNewTag, bRemoveTagAtZero) : 0.0f;
+}
+
+float FGameplayTagFloatStackContainer::AddValue(FGameplayTag Tag, float Delta, bool bCanAddNewTag, bool bRemoveTagAtZero)
+{
+	return FOps::CheckTag(Tag, TEXT("AddValue")) ? FOps::AddValue(*this, Tag, Delta, bCanAddNewTag, bRemoveTagAtZero) : 0.0f;
+}
+
+void FGameplayTagFloatStackContainer::SetRate(FGameplayTag Tag, float Rate, bool bCanAddNewTag)
+{
+	if (FOps::CheckTag(Tag, TEXT("SetRate")))
+	{
+		FOps::SetRate(*this, Tag, Rate, bCanAddNewTag);
+	}
+}
+
+
+float FGameplayTagFloatStackContainer::GetValue(FGameplayTag Tag) const
+{
+	return FOps::GetValue(*this, Tag);
+}
+
+float FGameplayTagFloatStackContainer::GetMaxValue(FGameplayTag Tag) const
+{
+	return FOps::GetMaxValue(*this, Tag);
+}
+
+float FGameplayTagFloatStackContainer::GetRate(FGameplayTag Tag) const
+{
+	return FOps::GetRate(*this, Tag);
+}
+
+bool FGameplayTagFloatStackContainer::ContainsTag(FGameplayTag Tag) const
+{
+	return FOps::ContainsTag(*this, Tag);
+}
+
+double FGameplayTagFloatStackContainer::GetValueSum(FGameplayTag ParentTag) const
+{
+	return FOps::GetValueSum(*this, ParentTag);
+}
+
+float FGameplayTagFloatStackContainer::GetValueMax(FGameplayTag ParentTag) const
+{
+	return FOps::GetValueMax(*this, ParentTag);
+}
+
+bool FGameplayTagFloatStackContainer::HasAnyValue(FGameplayTag ParentTag) const
+{
+	return FOps::HasAnyValue(*this, ParentTag);
+}
+
+#pragma endregion
@@ -0,0 +1,702 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "GameplayTag/GameplayTagStack.h"
+
+#include "GameplayTagValueStack.generated.h"
+
+struct FGameplayTagInt64StackChangeMessage;
+struct FGameplayTagFloatStackChangeMessage;
+
+
+/**
+ * List entry data for quick query of wide tag stacks
+ */
+template<typename ValueType>
+struct TFastGameplayTagValueStack
+{
+public:
+	using FValue = ValueType;
+
+	static constexpr bool bHasRate{ true };
+
+public:
+	ValueType Value{ 0 };
+
+	ValueType MaxValue{ TGameplayTagValueStackTraits<ValueType>::NoMax };
+
+	float Rate{ 0.0f };
+
+	double RateStartTime{ 0.0 };
+
+	//
+	// Index of the stack in the replicated list of the container
+	//
+	int32 StackIndex{ INDEX_NONE };
+
+};
+
+
+/**
+ * Represents one stack of a gameplay tag with an int64 value
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagInt64Stack : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagInt64Stack() {}
+
+	FGameplayTagInt64Stack(FGameplayTag InTag, int64 InValue, int64 InMaxValue)
+		: Tag(InTag)
+		, Value(InValue)
+		, MaxValue(InMaxValue)
+	{}
+
+public:
+	UPROPERTY()
+	FGameplayTag Tag;
+
+	UPROPERTY()
+	int64 Value{ 0 };
+
+	UPROPERTY()
+	int64 MaxValue{ -1 };
+
+	//
+	// Change of the value per second (0 if the value does not change over time)
+	//
+	UPROPERTY()
+	float Rate{ 0.0f };
+
+	//
+	// Server time at which Value was set (only used when Rate is not 0)
+	//
+	UPROPERTY()
+	double RateStartTime{ 0.0 };
+
+public:
+	FString GetDebugString() const;
+
+	/**
+	 * Compact serialization for replication (zig-zag and variable-length encoded values, MaxValue and Rate only when set)
+	 */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayTagInt64Stack> : public TStructOpsTypeTraitsBase2<FGameplayTagInt64Stack>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+
+/**
+ * Represents one stack of a gameplay tag with a float value
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagFloatStack : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagFloatStack() {}
+
+	FGameplayTagFloatStack(FGameplayTag InTag, float InValue, float InMaxValue)
+		: Tag(InTag)
+		, Value(InValue)
+		, MaxValue(InMaxValue)
+	{}
+
+public:
+	UPROPERTY()
+	FGameplayTag Tag;
+
+	UPROPERTY()
+	float Value{ 0.0f };
+
+	UPROPERTY()
+	float MaxValue{ -1.0f };
+
+	//
+	// Change of the value per second (0 if the value does not change over time)
+	//
+	UPROPERTY()
+	float Rate{ 0.0f };
+
+	//
+	// Server time at which Value was set (only used when Rate is not 0)
+	//
+	UPROPERTY()
+	double RateStartTime{ 0.0 };
+
+public:
+	FString GetDebugString() const;
+
+	/**
+	 * Compact serialization for replication (MaxValue and Rate only when set)
+	 */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayTagFloatStack> : public TStructOpsTypeTraitsBase2<FGameplayTagFloatStack>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+
+/**
+ * Change in the int64 value of a tag to be applied in a batch
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagInt64StackDelta
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagInt64StackDelta() {}
+
+	FGameplayTagInt64StackDelta(FGameplayTag InTag, int64 InDelta)
+		: Tag(InTag)
+		, Delta(InDelta)
+	{}
+
+public:
+	//
+	// Tag whose value will be changed
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag Tag;
+
+	//
+	// Value to add (subtracted if negative)
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	int64 Delta{ 0 };
+
+};
+
+
+/**
+ * Change in the float value of a tag to be applied in a batch
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagFloatStackDelta
+{
+	GENERATED_BODY()
+public:
+	FGameplayTagFloatStackDelta() {}
+
+	FGameplayTagFloatStackDelta(FGameplayTag InTag, float InDelta)
+		: Tag(InTag)
+		, Delta(InDelta)
+	{}
+
+public:
+	//
+	// Tag whose value will be changed
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag Tag;
+
+	//
+	// Value to add (subtracted if negative)
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	float Delta{ 0.0f };
+
+};
+
+
+/**
+ * Container of gameplay tag stacks with int64 values
+ * 
+ * Tips:
+ *	Shares the lookup modes, batching, aggregates, snapshots, message policy, replication policies and prediction
+ *	of FGameplayTagStackContainer through TGameplayTagStackOps.
+ *	Changes are broadcast on TAG_Message_TagStackInt64Change with FGameplayTagInt64StackChangeMessage.
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagInt64StackContainer : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	friend struct TGameplayTagStackOps<FGameplayTagInt64StackContainer>;
+
+public:
+	using FItem = FGameplayTagInt64Stack;
+	using FFastStack = TFastGameplayTagValueStack<int64>;
+	using FValue = int64;
+	using FDelta = FGameplayTagInt64StackDelta;
+	using FMessage = FGameplayTagInt64StackChangeMessage;
+	using FOps = TGameplayTagStackOps<FGameplayTagInt64StackContainer>;
+
+	static constexpr bool bHasRate{ true };
+
+	static constexpr auto ItemValue{ &FGameplayTagInt64Stack::Value };
+	static constexpr auto ItemMaxValue{ &FGameplayTagInt64Stack::MaxValue };
+
+public:
+	FGameplayTagInt64StackContainer()
+		: OwnerObject(nullptr)
+	{}
+
+	FGameplayTagInt64StackContainer(UObject* InOwnerObject, EGameplayTagStackMessagePolicy InMessagePolicy = EGameplayTagStackMessagePolicy::Immediate, EGameplayTagStackLookupMode InLookupMode = EGameplayTagStackLookupMode::Map)
+		: OwnerObject(InOwnerObject)
+		, MessagePolicy(InMessagePolicy)
+	{
+		State.LookupMode = InLookupMode;
+	}
+
+	//////////////////////////////////////////////////////////
+	// Container parameters
+public:
+	//
+	// Replicated list of gameplay tag stacks
+	//
+	UPROPERTY()
+	TArray<FGameplayTagInt64Stack> Stacks;
+
+	//
+	// Owner of this container.
+	//
+	UPROPERTY(NotReplicated)
+	TObjectPtr<UObject> OwnerObject;
+
+	//
+	// How change messages are broadcast for this container
+	//
+	UPROPERTY(NotReplicated)
+	EGameplayTagStackMessagePolicy MessagePolicy{ EGameplayTagStackMessagePolicy::Immediate };
+
+protected:
+	//
+	// Accelerated list of tag stacks for queries (used when LookupMode is Map)
+	//
+	TMap<FGameplayTag, FFastStack> FastStacks;
+
+	//
+	// Accelerated sorted list of tag stacks for queries (used when LookupMode is FlatArray)
+	//
+	TFlatGameplayTagStackMap<FFastStack> FlatStacks;
+
+	//
+	// Latest prediction ID acknowledged by the server (written by NetDeltaSerialize before the items, only for the owning connection)
+	//
+	UPROPERTY(NotReplicated)
+	int32 LastAcknowledgedPredictionId{ 0 };
+
+	//
+	// Lookup, batch, aggregate, snapshot, replication and prediction state
+	//
+	TGameplayTagStackContainerState<FFastStack> State;
+
+
+	///////////////////////////////////////////////////////////
+	// Options
+public:
+	void SetLookupMode(EGameplayTagStackLookupMode NewLookupMode);
+
+	EGameplayTagStackLookupMode GetLookupMode() const { return State.LookupMode; }
+
+	/**
+	 * Enable or disable maintaining aggregates for each parent tag (GetValueSum, GetValueMax and HasAnyValue become O(1))
+	 */
+	void SetTrackParentAggregates(bool bEnabled);
+
+	bool IsTrackingParentAggregates() const { return State.bTrackParentAggregates; }
+
+	/**
+	 * Enable or disable publishing snapshots readable from other threads
+	 */
+	void SetPublishSnapshots(bool bEnabled);
+
+	/**
+	 * Returns the latest published snapshot (or nullptr if publishing is disabled). Can be called from any thread.
+	 */
+	TGameplayTagStackSnapshotPtr<FFastStack> GetSnapshot() const { return State.SnapshotPublisher.Get(); }
+
+
+	///////////////////////////////////////////////////////////
+	// Replication
+public:
+	void PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize);
+	void PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize);
+	void PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	/**
+	 * Filters the stacks by their replication policy for the connection currently being serialized
+	 */
+	template<typename Type, typename SerializerType>
+	bool ShouldWriteFastArrayItem(const Type& Item, const bool bIsWritingOnClient)
+	{
+		return TGameplayTagStackOps<SerializerType>::ShouldWriteItem(*this, Item, bIsWritingOnClient);
+	}
+
+	uint32 GetNumElidedMutations() const { return State.NumElidedMutations; }
+
+
+	///////////////////////////////////////////////////////////
+	// Messages
+public:
+	/**
+	 * Register to receive the change messages of the specified tag of this container only (all tags if Tag is empty)
+	 */
+	FGameplayMessageListenerHandle RegisterStackChangeListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagInt64StackChangeMessage&)>&& Callback) const;
+
+protected:
+	static FGameplayTag GetMessageChannel();
+
+	FGameplayTagInt64StackChangeMessage MakeChangeMessage(FGameplayTag Tag, int64 Value, int64 MaxValue, float Rate) const;
+
+
+	///////////////////////////////////////////////////////////
+	// Prediction
+public:
+	/**
+	 * Predict a value change on the client ahead of the server (same rules as FGameplayTagStackContainer::PredictStack)
+	 */
+	void PredictValue(FGameplayTag Tag, int64 Delta, int32 PredictionId);
+
+	void AcknowledgePrediction(int32 PredictionId);
+
+	void ClearPredictions();
+
+	bool HasPendingPrediction(FGameplayTag Tag) const { return FOps::HasPendingPrediction(*this, Tag); }
+
+
+	///////////////////////////////////////////////////////////
+	// Batch
+public:
+	/**
+	 * Start a batch of mutations
+	 * 
+	 * Tips:
+	 *	@see TGameplayTagStackBatchScope
+	 */
+	void BeginBatch();
+
+	/**
+	 * End a batch of mutations and apply the deferred dirty marks and change messages
+	 */
+	void EndBatch();
+
+	/**
+	 * Apply the value changes of many tags as a single batch (deltas for the same tag are summed first)
+	 */
+	void ApplyValueDeltas(TConstArrayView<FGameplayTagInt64StackDelta> Deltas, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
+
+	///////////////////////////////////////////////////////////
+	// Mutation
+public:
+	void SetMaxValue(FGameplayTag Tag, int64 MaxValue, bool bCanAddNewTag = true);
+	int64 SetValue(FGameplayTag Tag, int64 Value, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
+	/**
+	 * Adds the delta to the value of the tag (subtracted if negative)
+	 */
+	int64 AddValue(FGameplayTag Tag, int64 Delta, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
+	/**
+	 * Set the change of the value per second of the tag
+	 * 
+	 * Tips:
+	 *	The value is evaluated lazily from the server time on read, so nothing ticks and the stack only replicates when the rate changes.
+	 *	No message is broadcast when the value reaches 0 or the max by itself, and bRemoveTagAtZero is not applied to it.
+	 */
+	void SetRate(FGameplayTag Tag, float Rate, bool bCanAddNewTag = true);
+
+
+	///////////////////////////////////////////////////////////
+	// Query
+public:
+	/**
+	 * Returns the current value of the tag (evaluated at the current server time if a rate is set)
+	 */
+	int64 GetValue(FGameplayTag Tag) const;
+
+	int64 GetMaxValue(FGameplayTag Tag) const;
+
+	float GetRate(FGameplayTag Tag) const;
+
+	bool ContainsTag(FGameplayTag Tag) const;
+
+	/**
+	 * Returns the total of the stored values of the specified tag and all of its child tags
+	 */
+	int64 GetValueSum(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns the largest stored value among the specified tag and all of its child tags (or 0 if none is present)
+	 */
+	int64 GetValueMax(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns true if the specified tag or any of its child tags has a value greater than 0
+	 */
+	bool HasAnyValue(FGameplayTag ParentTag) const;
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayTagInt64StackContainer> : public TStructOpsTypeTraitsBase2<FGameplayTagInt64StackContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+
+/**
+ * Container of gameplay tag stacks with float values
+ * 
+ * Tips:
+ *	Shares the lookup modes, batching, aggregates, snapshots, message policy, replication policies and prediction
+ *	of FGameplayTagStackContainer through TGameplayTagStackOps.
+ *	Changes are broadcast on TAG_Message_TagStackFloatChange with FGameplayTagFloatStackChangeMessage.
+ */
+USTRUCT(BlueprintType)
+struct GFCORE_API FGameplayTagFloatStackContainer : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	friend struct TGameplayTagStackOps<FGameplayTagFloatStackContainer>;
+
+public:
+	using FItem = FGameplayTagFloatStack;
+	using FFastStack = TFastGameplayTagValueStack<float>;
+	using FValue = float;
+	using FDelta = FGameplayTagFloatStackDelta;
+	using FMessage = FGameplayTagFloatStackChangeMessage;
+	using FOps = TGameplayTagStackOps<FGameplayTagFloatStackContainer>;
+
+	static constexpr bool bHasRate{ true };
+
+	static constexpr auto ItemValue{ &FGameplayTagFloatStack::Value };
+	static constexpr auto ItemMaxValue{ &FGameplayTagFloatStack::MaxValue };
+
+public:
+	FGameplayTagFloatStackContainer()
+		: OwnerObject(nullptr)
+	{}
+
+	FGameplayTagFloatStackContainer(UObject* InOwnerObject, EGameplayTagStackMessagePolicy InMessagePolicy = EGameplayTagStackMessagePolicy::Immediate, EGameplayTagStackLookupMode InLookupMode = EGameplayTagStackLookupMode::Map)
+		: OwnerObject(InOwnerObject)
+		, MessagePolicy(InMessagePolicy)
+	{
+		State.LookupMode = InLookupMode;
+	}
+
+	//////////////////////////////////////////////////////////
+	// Container parameters
+public:
+	//
+	// Replicated list of gameplay tag stacks
+	//
+	UPROPERTY()
+	TArray<FGameplayTagFloatStack> Stacks;
+
+	//
+	// Owner of this container.
+	//
+	UPROPERTY(NotReplicated)
+	TObjectPtr<UObject> OwnerObject;
+
+	//
+	// How change messages are broadcast for this container
+	//
+	UPROPERTY(NotReplicated)
+	EGameplayTagStackMessagePolicy MessagePolicy{ EGameplayTagStackMessagePolicy::Immediate };
+
+protected:
+	//
+	// Accelerated list of tag stacks for queries (used when LookupMode is Map)
+	//
+	TMap<FGameplayTag, FFastStack> FastStacks;
+
+	//
+	// Accelerated sorted list of tag stacks for queries (used when LookupMode is FlatArray)
+	//
+	TFlatGameplayTagStackMap<FFastStack> FlatStacks;
+
+	//
+	// Latest prediction ID acknowledged by the server (written by NetDeltaSerialize before the items, only for the owning connection)
+	//
+	UPROPERTY(NotReplicated)
+	int32 LastAcknowledgedPredictionId{ 0 };
+
+	//
+	// Lookup, batch, aggregate, snapshot, replication and prediction state
+	//
+	TGameplayTagStackContainerState<FFastStack> State;
+
+
+	///////////////////////////////////////////////////////////
+	// Options
+public:
+	void SetLookupMode(EGameplayTagStackLookupMode NewLookupMode);
+
+	EGameplayTagStackLookupMode GetLookupMode() const { return State.LookupMode; }
+
+	/**
+	 * Enable or disable maintaining aggregates for each parent tag (GetValueSum, GetValueMax and HasAnyValue become O(1))
+	 */
+	void SetTrackParentAggregates(bool bEnabled);
+
+	bool IsTrackingParentAggregates() const { return State.bTrackParentAggregates; }
+
+	/**
+	 * Enable or disable publishing snapshots readable from other threads
+	 */
+	void SetPublishSnapshots(bool bEnabled);
+
+	/**
+	 * Returns the latest published snapshot (or nullptr if publishing is disabled). Can be called from any thread.
+	 */
+	TGameplayTagStackSnapshotPtr<FFastStack> GetSnapshot() const { return State.SnapshotPublisher.Get(); }
+
+
+	///////////////////////////////////////////////////////////
+	// Replication
+public:
+	void PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize);
+	void PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize);
+	void PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	/**
+	 * Filters the stacks by their replication policy for the connection currently being serialized
+	 */
+	template<typename Type, typename SerializerType>
+	bool ShouldWriteFastArrayItem(const Type& Item, const bool bIsWritingOnClient)
+	{
+		return TGameplayTagStackOps<SerializerType>::ShouldWriteItem(*this, Item, bIsWritingOnClient);
+	}
+
+	uint32 GetNumElidedMutations() const { return State.NumElidedMutations; }
+
+
+	///////////////////////////////////////////////////////////
+	// Messages
+public:
+	/**
+	 * Register to receive the change messages of the specified tag of this container only (all tags if Tag is empty)
+	 */
+	FGameplayMessageListenerHandle RegisterStackChangeListener(FGameplayTag Tag, TFunction<void(FGameplayTag, const FGameplayTagFloatStackChangeMessage&)>&& Callback) const;
+
+protected:
+	static FGameplayTag GetMessageChannel();
+
+	FGameplayTagFloatStackChangeMessage MakeChangeMessage(FGameplayTag Tag, float Value, float MaxValue, float Rate) const;
+
+
+	///////////////////////////////////////////////////////////
+	// Prediction
+public:
+	/**
+	 * Predict a value change on the client ahead of the server (same rules as FGameplayTagStackContainer::PredictStack)
+	 */
+	void PredictValue(FGameplayTag Tag, float Delta, int32 PredictionId);
+
+	void AcknowledgePrediction(int32 PredictionId);
+
+	void ClearPredictions();
+
+	bool HasPendingPrediction(FGameplayTag Tag) const { return FOps::HasPendingPrediction(*this, Tag); }
+
+
+	///////////////////////////////////////////////////////////
+	// Batch
+public:
+	/**
+	 * Start a batch of mutations
+	 * 
+	 * Tips:
+	 *	@see TGameplayTagStackBatchScope
+	 */
+	void BeginBatch();
+
+	/**
+	 * End a batch of mutations and apply the deferred dirty marks and change messages
+	 */
+	void EndBatch();
+
+	/**
+	 * Apply the value changes of many tags as a single batch (deltas for the same tag are summed first)
+	 */
+	void ApplyValueDeltas(TConstArrayView<FGameplayTagFloatStackDelta> Deltas, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
+
+	///////////////////////////////////////////////////////////
+	// Mutation
+public:
+	void SetMaxValue(FGameplayTag Tag, float MaxValue, bool bCanAddNewTag = true);
+	float SetValue(FGameplayTag Tag, float Value, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
+	/**
+	 * Adds the delta to the value of the tag (subtracted if negative)
+	 */
+	float AddValue(FGameplayTag Tag, float Delta, bool bCanAddNewTag = true, bool bRemoveTagAtZero = false);
+
+	/**
+	 * Set the change of the value per second of the tag
+	 * 
+	 * Tips:
+	 *	The value is evaluated lazily from the server time on read, so nothing ticks and the stack only replicates when the rate changes.
+	 *	No message is broadcast when the value reaches 0 or the max by itself, and bRemoveTagAtZero is not applied to it.
+	 */
+	void SetRate(FGameplayTag Tag, float Rate, bool bCanAddNewTag = true);
+
+
+	///////////////////////////////////////////////////////////
+	// Query
+public:
+	/**
+	 * Returns the current value of the tag (evaluated at the current server time if a rate is set)
+	 */
+	float GetValue(FGameplayTag Tag) const;
+
+	float GetMaxValue(FGameplayTag Tag) const;
+
+	float GetRate(FGameplayTag Tag) const;
+
+	bool ContainsTag(FGameplayTag Tag) const;
+
+	/**
+	 * Returns the total of the stored values of the specified tag and all of its child tags
+	 */
+	double GetValueSum(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns the largest stored value among the specified tag and all of its child tags (or 0 if none is present)
+	 */
+	float GetValueMax(FGameplayTag ParentTag) const;
+
+	/**
+	 * Returns true if the specified tag or any of its child tags has a value greater than 0
+	 */
+	bool HasAnyValue(FGameplayTag ParentTag) const;
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayTagFloatStackContainer> : public TStructOpsTypeTraitsBase2<FGameplayTagFloatStackContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
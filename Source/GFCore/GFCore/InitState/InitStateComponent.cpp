@@ -2,6 +2,9 @@
 
 #include "InitState/InitStateComponent.h"
 
+#include "InitState/InitStateSubsystem.h"
+#include "InitState/InitStateDependencyGraph.h"
+#include "InitState/InitStateTransitionTable.h"
 #include "InitState/InitStateTags.h"
 
 #include "Components/GameFrameworkComponentManager.h"
@@ -34,16 +37,29 @@ void UInitStateComponent::OnRegister()
 	// Register this component in the GameFrameworkComponentManager.
 
 	RegisterInitStateFeature();
+
+	// Declare the features this feature depends on in the dependency graph of the actor class
+
+	FInitStateDependencyGraph::DeclareFeature(GetOwner(), GetFeatureName(),
+		[this](TArray<FInitStateFeatureDependency>& OutDependencies)
+		{
+			GetInitStateDependencies(OutDependencies);
+		}
+	);
 }
 
 void UInitStateComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// Start listening for changes in the initialization state of all features 
+	// Get woken up when the declared dependencies are satisfied.
+	// If the world has no scheduler, start listening for changes in the initialization state of all features 
 	// related to the Pawn that owns this component.
 
-	BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
+	if (!UInitStateSubsystem::RegisterFeature(this, GetFeatureName()))
+	{
+		BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
+	}
 
 	// Change the initialization state of this component to [Spawned]
 
@@ -51,11 +67,13 @@ void UInitStateComponent::BeginPlay()
 
 	// Check if initialization process can continue
 
-	CheckDefaultInitialization();
+	UInitStateSubsystem::RequestCheckDefaultInitialization(this);
 }
 
 void UInitStateComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	UInitStateSubsystem::UnregisterFeature(this, GetFeatureName());
+
 	UnregisterInitStateFeature();
 
 	Super::EndPlay(EndPlayReason);
@@ -66,134 +84,149 @@ bool UInitStateComponent::CanChangeInitState(UGameFrameworkComponentManager* Man
 {
 	check(Manager);
 
-	/**
-	 * [None] -> [Spawned]
-	 */
-	if (!CurrentState.IsValid() && DesiredState == TAG_InitState_Spawned)
-	{
-		if (GetOwner() == nullptr)
-		{
-			return false;
-		}
+	// Only the transition to the next state of the chain is allowed
 
-		return CanChangeInitStateToSpawned(Manager);
+	const auto& Table{ FInitStateTransitionTable::Get() };
+	const auto StateIndex{ Table.FindTransition(CurrentState, DesiredState) };
+
+	if (StateIndex == INDEX_NONE)
+	{
+		return false;
 	}
 
-	/**
-	 * [InitState Spawned] -> [InitState DataAvailable]
-	 */
-	else if (CurrentState == TAG_InitState_Spawned && DesiredState == TAG_InitState_DataAvailable)
+	// Features declared as dependencies must have reached the required states
+
+	const auto* Owner{ GetOwner() };
+
+	if (!Owner || !FInitStateDependencyGraph::Get(Owner->GetClass()).AreDependenciesMet(Manager, GetOwner(), GetFeatureName(), DesiredState))
 	{
-		return CanChangeInitStateToDataAvailable(Manager);
+		return false;
 	}
 
-	/**
-	 * [DataAvailable] -> [DataInitialized]
-	 */
-	else if (CurrentState == TAG_InitState_DataAvailable && DesiredState == TAG_InitState_DataInitialized)
+	switch (Table.GetBuiltinState(StateIndex))
 	{
-		if (!Manager->HaveAllFeaturesReachedInitState(GetOwner(), TAG_InitState_DataInitialized, NAME_ActorFeatureName))
-		{
-			return false;
-		}
+	case EInitStateBuiltin::Spawned:
+		return CanChangeInitStateToSpawned(Manager);
 
+	case EInitStateBuiltin::DataAvailable:
+		return CanChangeInitStateToDataAvailable(Manager);
+
+	case EInitStateBuiltin::DataInitialized:
 		return CanChangeInitStateToDataInitialized(Manager);
-	}
 
-	/**
-	 * [DataInitialized] -> [GameplayReady]
-	 */
-	else if (CurrentState == TAG_InitState_DataInitialized && DesiredState == TAG_InitState_GameplayReady)
-	{
+	case EInitStateBuiltin::GameplayReady:
 		return CanChangeInitStateToGameplayReady(Manager);
-	}
 
-	return false;
+	default:
+		return CanChangeInitStateToCustom(Manager, DesiredState);
+	}
 }
 
 void UInitStateComponent::HandleChangeInitState(UGameFrameworkComponentManager* Manager, FGameplayTag CurrentState, FGameplayTag DesiredState)
 {
 	check(Manager);
 
-	/**
-	 * [InitState None] -> [InitState Spawned]
-	 */
-	if (!CurrentState.IsValid() && DesiredState == TAG_InitState_Spawned)
+	const auto& Table{ FInitStateTransitionTable::Get() };
+
+	switch (Table.GetBuiltinState(Table.GetStateIndex(DesiredState)))
 	{
+	case EInitStateBuiltin::Spawned:
 		HandleChangeInitStateToSpawned(Manager);
-	}
+		break;
 
-	/**
-	 * [InitState Spawned] -> [InitState DataAvailable]
-	 */
-	else if (CurrentState == TAG_InitState_Spawned && DesiredState == TAG_InitState_DataAvailable)
-	{
+	case EInitStateBuiltin::DataAvailable:
 		HandleChangeInitStateToDataAvailable(Manager);
-	}
+		break;
 
-	/**
-	 * [InitState DataAvailable] -> [InitState DataInitialized]
-	 */
-	else if (CurrentState == TAG_InitState_DataAvailable && DesiredState == TAG_InitState_DataInitialized)
-	{
+	case EInitStateBuiltin::DataInitialized:
 		HandleChangeInitStateToDataInitialized(Manager);
-	}
+		break;
 
-	/**
-	 * [InitState DataInitialized] -> [InitState GameplayReady]
-	 */
-	else if (CurrentState == TAG_InitState_DataInitialized && DesiredState == TAG_InitState_GameplayReady)
-	{
+	case EInitStateBuiltin::GameplayReady:
 		OnGameReadyDelegate.Broadcast();
 
 		UGameFrameworkComponentManager::SendGameFrameworkComponentExtensionEvent(GetOwner(), NAME_InitStateComplete);
 
 		HandleChangeInitStateToGameplayReady(Manager);
+		break;
+
+	default:
+		HandleChangeInitStateToCustom(Manager, DesiredState);
+		break;
 	}
 }
 
 void UInitStateComponent::OnActorInitStateChanged(const FActorInitStateChangedParams& Params)
 {
-	// Executed when the initialization state is changed 
-	// by a feature other than this component of the actor that owns this component.
+	// Only wake up when the change satisfied the declared dependencies
 
-	if (Params.FeatureName != NAME_ActorFeatureName)
+	if (UInitStateSubsystem::ShouldWakeFeature(this, GetFeatureName(), Params))
 	{
-		/**
-		 * -> [DataInitialized]
-		 */
-		if (Params.FeatureState == TAG_InitState_DataInitialized)
-		{
-			CheckDefaultInitialization();
-		}
+		UInitStateSubsystem::RequestCheckDefaultInitialization(this);
+	}
+}
 
-		/**
-		 * -> [GameplayReady]
-		 */
-		else if (Params.FeatureState == TAG_InitState_GameplayReady)
-		{
-			CheckDefaultInitialization();
-		}
+void UInitStateComponent::GetInitStateDependencies(TArray<FInitStateFeatureDependency>& OutDependencies) const
+{
+	/**
+	 * [DataInitialized] requires all other features to be [DataInitialized]
+	 */
+	OutDependencies.Emplace(TAG_InitState_DataInitialized, NAME_None, TAG_InitState_DataInitialized);
+}
+
+void UInitStateComponent::OnReleasedToPool()
+{
+	// Rewind the init state of this feature without re-creating the component
+
+	UInitStateSubsystem::UnregisterFeature(this, GetFeatureName());
+
+	UnregisterInitStateFeature();
+	RegisterInitStateFeature();
+}
+
+void UInitStateComponent::OnReacquiredFromPool(EInitStatePoolReacquireMode Mode)
+{
+	// Rebind the listener that was removed with the feature registration
+
+	if (!UInitStateSubsystem::RegisterFeature(this, GetFeatureName()))
+	{
+		BindOnActorInitStateChanged(NAME_None, FGameplayTag(), false);
 	}
+
+	// Change the initialization state of this component to [Spawned]
+
+	ensureMsgf(TryToChangeInitState(TAG_InitState_Spawned), TEXT("[%s] on [%s]."), *GetNameSafe(this), *GetNameSafe(GetOwner()));
+
+	// Skip the data gathering if the data of the previous use is still valid
+
+	if (Mode == EInitStatePoolReacquireMode::RestoreDataInitialized)
+	{
+		UInitStateSubsystem::FastForwardFeature(this, GetFeatureName(), TAG_InitState_DataInitialized);
+	}
+
+	// Check if initialization process can continue
+
+	UInitStateSubsystem::RequestCheckDefaultInitialization(this);
 }
 
 void UInitStateComponent::CheckDefaultInitialization()
 {
 	// Perform initialization state checks on other features before checking the initialization state of this component
+	// If the world has a scheduler, the features registered with it are woken up through the dependency graph when their dependencies are satisfied,
+	// so only the features not registered with it are checked here
 
-	CheckDefaultInitializationForImplementers();
-
-	// @TODO: Allow changes from DeveloperSetting
+	const auto* World{ GetWorld() };
 
-	static const TArray<FGameplayTag> StateChain
+	if (!World || !World->GetSubsystem<UInitStateSubsystem>())
 	{
-		TAG_InitState_Spawned,
-		TAG_InitState_DataAvailable,
-		TAG_InitState_DataInitialized,
-		TAG_InitState_GameplayReady
-	};
+		CheckDefaultInitializationForImplementers();
+	}
+	else
+	{
+		UInitStateSubsystem::CheckUnregisteredImplementers(this, GetFeatureName());
+	}
 
-	ContinueInitStateChain(StateChain);
+	ContinueInitStateChain(FInitStateTransitionTable::Get().GetStateChain());
 }
 
 
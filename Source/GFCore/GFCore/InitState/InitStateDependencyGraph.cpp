@@ -0,0 +1,147 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "InitState/InitStateDependencyGraph.h"
+
+#include "Components/GameFrameworkComponentManager.h"
+
+
+//
+// Graphs by actor class
+//
+static TMap<TObjectKey<UClass>, TUniquePtr<FInitStateDependencyGraph>> InitStateDependencyGraphs;
+
+
+FInitStateDependencyGraph& FInitStateDependencyGraph::Get(const UClass* ActorClass)
+{
+	check(IsInGameThread());
+
+	auto& Graph{ InitStateDependencyGraphs.FindOrAdd(ActorClass) };
+
+	if (!Graph.IsValid())
+	{
+		Graph = MakeUnique<FInitStateDependencyGraph>();
+	}
+
+	return *Graph;
+}
+
+void FInitStateDependencyGraph::Reset()
+{
+	check(IsInGameThread());
+
+	InitStateDependencyGraphs.Reset();
+}
+
+void FInitStateDependencyGraph::DeclareFeature(const AActor* Actor, FName Feature, TFunctionRef<void(TArray<FInitStateFeatureDependency>&)> GatherDependencies)
+{
+	check(Actor);
+
+	auto& Graph{ Get(Actor->GetClass()) };
+
+	if (!Graph.ContainsFeature(Feature))
+	{
+		TArray<FInitStateFeatureDependency> NewDependencies;
+		GatherDependencies(NewDependencies);
+
+		Graph.AddFeature(Feature, MoveTemp(NewDependencies));
+	}
+}
+
+void FInitStateDependencyGraph::AddFeature(FName Feature, TArray<FInitStateFeatureDependency>&& InDependencies)
+{
+	for (const auto& Dependency : InDependencies)
+	{
+		Dependents.FindOrAdd(Dependency.RequiredFeature).Add({ Feature, Dependency.State });
+	}
+
+	Dependencies.Add(Feature, MoveTemp(InDependencies));
+}
+
+bool FInitStateDependencyGraph::AreDependenciesMet(UGameFrameworkComponentManager* Manager, AActor* Actor, FName Feature, FGameplayTag State) const
+{
+	check(Manager);
+
+	if (const auto* FeatureDependencies{ Dependencies.Find(Feature) })
+	{
+		for (const auto& Dependency : *FeatureDependencies)
+		{
+			if (Dependency.State != State)
+			{
+				continue;
+			}
+
+			const auto bMet
+			{
+				Dependency.RequiredFeature.IsNone() ?
+				Manager->HaveAllFeaturesReachedInitState(Actor, Dependency.RequiredState, Feature) :
+				Manager->HasFeatureReachedInitState(Actor, Dependency.RequiredFeature, Dependency.RequiredState)
+			};
+
+			if (!bMet)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FInitStateDependencyGraph::ShouldWakeDependent(UGameFrameworkComponentManager* Manager, AActor* Actor, const FDependent& Dependent, FName ChangedFeature) const
+{
+	// A feature does not depend on itself, even as one of all features
+
+	if (Dependent.Feature == ChangedFeature)
+	{
+		return false;
+	}
+
+	// Already entered the gated state, nothing is waiting for this dependency
+
+	if (Manager->HasFeatureReachedInitState(Actor, Dependent.Feature, Dependent.State))
+	{
+		return false;
+	}
+
+	return AreDependenciesMet(Manager, Actor, Dependent.Feature, Dependent.State);
+}
+
+void FInitStateDependencyGraph::GetFeaturesToWake(UGameFrameworkComponentManager* Manager, const FActorInitStateChangedParams& Params, TArray<FName, TInlineAllocator<8>>& OutFeatures) const
+{
+	check(Manager);
+
+	for (const auto& RequiredFeature : { Params.FeatureName, FName(NAME_None) })
+	{
+		if (const auto* FeatureDependents{ Dependents.Find(RequiredFeature) })
+		{
+			for (const auto& Dependent : *FeatureDependents)
+			{
+				if (ShouldWakeDependent(Manager, Params.OwningActor, Dependent, Params.FeatureName))
+				{
+					OutFeatures.AddUnique(Dependent.Feature);
+				}
+			}
+		}
+	}
+}
+
+bool FInitStateDependencyGraph::ShouldWakeFeature(UGameFrameworkComponentManager* Manager, FName Feature, const FActorInitStateChangedParams& Params) const
+{
+	check(Manager);
+
+	if (const auto* FeatureDependencies{ Dependencies.Find(Feature) })
+	{
+		for (const auto& Dependency : *FeatureDependencies)
+		{
+			if (Dependency.RequiredFeature.IsNone() || (Dependency.RequiredFeature == Params.FeatureName))
+			{
+				if (ShouldWakeDependent(Manager, Params.OwningActor, { Feature, Dependency.State }, Params.FeatureName))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,118 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "GameplayTagContainer.h"
+
+class UGameFrameworkComponentManager;
+struct FActorInitStateChangedParams;
+
+
+/**
+ * Requirement that must be satisfied before a feature can enter a state
+ */
+struct GFCORE_API FInitStateFeatureDependency
+{
+public:
+	FInitStateFeatureDependency() {}
+
+	FInitStateFeatureDependency(FGameplayTag InState, FName InRequiredFeature, FGameplayTag InRequiredState)
+		: State(InState), RequiredFeature(InRequiredFeature), RequiredState(InRequiredState)
+	{}
+
+public:
+	//
+	// State of the dependent feature that requires this dependency
+	//
+	FGameplayTag State;
+
+	//
+	// Feature that must have reached the required state (NAME_None for all other features of the actor)
+	//
+	FName RequiredFeature;
+
+	//
+	// State that the required feature must have reached
+	//
+	FGameplayTag RequiredState;
+
+};
+
+
+/**
+ * Dependencies between the init state features of an actor class
+ * 
+ * Tips:
+ *	Features declare their dependencies once per actor class when they are registered.
+ *	The graph keeps the reverse edges so that a state change only wakes up the features whose dependencies it satisfied.
+ */
+class GFCORE_API FInitStateDependencyGraph
+{
+public:
+	FInitStateDependencyGraph() {}
+
+protected:
+	/**
+	 * Feature that depends on another feature, and its state gated by the dependency
+	 */
+	struct FDependent
+	{
+		FName Feature;
+		FGameplayTag State;
+	};
+
+	//
+	// Dependencies by dependent feature
+	//
+	TMap<FName, TArray<FInitStateFeatureDependency>> Dependencies;
+
+	//
+	// Dependents by required feature (NAME_None for the dependents of all features)
+	//
+	TMap<FName, TArray<FDependent>> Dependents;
+
+public:
+	/**
+	 * Returns the graph of the actor class
+	 */
+	static FInitStateDependencyGraph& Get(const UClass* ActorClass);
+
+	/**
+	 * Discard the graphs of all actor classes
+	 * 
+	 * Tips:
+	 *	Called when the last game world is cleaned up, so that reloaded classes and edited dependencies are declared again.
+	 */
+	static void Reset();
+
+	/**
+	 * Declare the dependencies of the feature on the graph of the actor class if it has not been declared yet
+	 */
+	static void DeclareFeature(const AActor* Actor, FName Feature, TFunctionRef<void(TArray<FInitStateFeatureDependency>&)> GatherDependencies);
+
+	/**
+	 * Returns whether the feature has been declared
+	 */
+	bool ContainsFeature(FName Feature) const { return Dependencies.Contains(Feature); }
+
+	/**
+	 * Returns whether all dependencies of the feature for entering the state are satisfied
+	 */
+	bool AreDependenciesMet(UGameFrameworkComponentManager* Manager, AActor* Actor, FName Feature, FGameplayTag State) const;
+
+	/**
+	 * Collect the features whose dependencies were all satisfied by the state change and that have not entered the gated state yet
+	 */
+	void GetFeaturesToWake(UGameFrameworkComponentManager* Manager, const FActorInitStateChangedParams& Params, TArray<FName, TInlineAllocator<8>>& OutFeatures) const;
+
+	/**
+	 * Returns whether the state change satisfied all dependencies of the feature for one of its states
+	 */
+	bool ShouldWakeFeature(UGameFrameworkComponentManager* Manager, FName Feature, const FActorInitStateChangedParams& Params) const;
+
+protected:
+	void AddFeature(FName Feature, TArray<FInitStateFeatureDependency>&& InDependencies);
+
+	bool ShouldWakeDependent(UGameFrameworkComponentManager* Manager, AActor* Actor, const FDependent& Dependent, FName ChangedFeature) const;
+
+};
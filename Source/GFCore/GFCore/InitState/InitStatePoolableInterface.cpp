@@ -0,0 +1,11 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "InitState/InitStatePoolableInterface.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(InitStatePoolableInterface)
+
+
+UInitStatePoolableInterface::UInitStatePoolableInterface(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
@@ -0,0 +1,56 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "UObject/Interface.h"
+
+#include "InitStatePoolableInterface.generated.h"
+
+
+/**
+ * How the init state chain of a feature continues when its actor is reacquired from a pool
+ */
+UENUM(BlueprintType)
+enum class EInitStatePoolReacquireMode : uint8
+{
+	// Go through every state of the chain again
+
+	Replay,
+
+	// Jump to [DataInitialized] and keep the data gathered during the previous use
+
+	RestoreDataInitialized
+};
+
+
+/**
+ * Interface for features that can be reused when their actor is released to and reacquired from a pool
+ */
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class GFCORE_API UInitStatePoolableInterface : public UInterface
+{
+	GENERATED_BODY()
+public:
+	UInitStatePoolableInterface(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+};
+
+class GFCORE_API IInitStatePoolableInterface
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Called when the actor is released to a pool
+	 * 
+	 * Tips:
+	 *	The init state of the feature should be rewound so that the chain can start again.
+	 */
+	virtual void OnReleasedToPool() {}
+
+	/**
+	 * Called when the actor is reacquired from a pool
+	 */
+	virtual void OnReacquiredFromPool(EInitStatePoolReacquireMode Mode) {}
+
+};
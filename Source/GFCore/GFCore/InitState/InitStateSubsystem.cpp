@@ -0,0 +1,782 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "InitState/InitStateSubsystem.h"
+
+#include "InitState/InitStateComponent.h"
+#include "InitState/InitStateDependencyGraph.h"
+#include "InitState/InitStateTransitionTable.h"
+#include "GameFrameworkDeveloperSettings.h"
+#include "GFCoreLogs.h"
+
+#include "Components/GameFrameworkComponentManager.h"
+#include "Components/GameFrameworkInitStateInterface.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(InitStateSubsystem)
+
+
+DECLARE_STATS_GROUP(TEXT("InitState"), STATGROUP_InitState, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Evaluate Actor"), STAT_InitState_EvaluateActor, STATGROUP_InitState);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Evaluations"), STAT_InitState_NumEvaluations, STATGROUP_InitState);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Merged Requests (Evaluations Saved)"), STAT_InitState_NumMergedRequests, STATGROUP_InitState);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dependency Wakes"), STAT_InitState_NumDependencyWakes, STATGROUP_InitState);
+
+
+//
+// Maximum number of passes over the pending features of an actor in one evaluation
+//
+static constexpr int32 InitStateMaxEvaluationPasses{ 32 };
+
+//
+// Number of subsystems alive, used to discard the dependency graphs when the last game world is cleaned up
+//
+static int32 NumInitStateSubsystems{ 0 };
+
+
+//////////////////////////////////////////////////////////////////////
+// Subsystem
+
+#pragma region Subsystem
+
+void UInitStateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const auto* DevSettings{ GetDefault<UGameFrameworkDeveloperSettings>() };
+
+	bDeferEvaluation = DevSettings->bDeferInitStateEvaluation;
+	WatchdogBudget = DevSettings->InitStateWatchdogBudget;
+
+	++NumInitStateSubsystems;
+}
+
+void UInitStateSubsystem::Deinitialize()
+{
+	UE_LOG(LogGameCore_InitState, Log, TEXT("InitStateSubsystem: %llu evaluations, %llu requests merged, %llu dependency wakes"), NumEvaluations, NumMergedRequests, NumDependencyWakes);
+
+	for (auto& KVP : BoundActors)
+	{
+		auto* Actor{ KVP.Key.Get() };
+		auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+		if (Manager)
+		{
+			Manager->UnregisterActorInitStateDelegate(Actor, KVP.Value.InitStateChangedHandle);
+		}
+	}
+
+	BoundActors.Reset();
+	ActorEntries.Reset();
+	PendingActors.Reset();
+
+	// The graphs are declared again by the features of the next session (e.g. after the end of PIE or a class reload)
+
+	if (--NumInitStateSubsystems == 0)
+	{
+		FInitStateDependencyGraph::Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+void UInitStateSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FlushPendingActors();
+
+	// The watchdog does not need to check every frame
+
+	if (WatchdogBudget > 0.0f)
+	{
+		WatchdogElapsed += DeltaTime;
+
+		if (WatchdogElapsed >= 1.0f)
+		{
+			WatchdogElapsed = 0.0f;
+
+			CheckStuckActors();
+		}
+	}
+}
+
+TStatId UInitStateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInitStateSubsystem, STATGROUP_Tickables);
+}
+
+bool UInitStateSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return (WorldType == EWorldType::Game) || (WorldType == EWorldType::PIE);
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// Scheduling
+
+#pragma region Scheduling
+
+void UInitStateSubsystem::RequestCheckDefaultInitialization(UActorComponent* Feature)
+{
+	check(Feature);
+
+	const auto* World{ Feature->GetWorld() };
+
+	if (auto* Subsystem{ World ? World->GetSubsystem<UInitStateSubsystem>() : nullptr })
+	{
+		Subsystem->MarkFeatureDirty(Feature);
+	}
+	else if (auto* Interface{ Cast<IGameFrameworkInitStateInterface>(Feature) })
+	{
+		Interface->CheckDefaultInitialization();
+	}
+}
+
+void UInitStateSubsystem::MarkFeatureDirty(UActorComponent* Feature)
+{
+	auto* Actor{ Feature ? Feature->GetOwner() : nullptr };
+
+	if (!Actor)
+	{
+		return;
+	}
+
+	auto& Entry{ ActorEntries.FindOrAdd(Actor) };
+
+	// Merge with the pending request of the same feature
+
+	if (Entry.DirtyFeatures.Contains(Feature))
+	{
+		INC_DWORD_STAT(STAT_InitState_NumMergedRequests);
+		++NumMergedRequests;
+
+		return;
+	}
+
+	Entry.DirtyFeatures.Add(Feature);
+
+	// The running evaluation will pick it up in its next pass
+
+	if (Entry.bIsEvaluating)
+	{
+		return;
+	}
+
+	if (bDeferEvaluation)
+	{
+		AddPendingActor(Actor, Entry);
+	}
+	else
+	{
+		EvaluateActor(Actor);
+	}
+}
+
+void UInitStateSubsystem::EvaluateActor(AActor* Actor)
+{
+	auto* Entry{ ActorEntries.Find(Actor) };
+
+	if (!Entry || Entry->bIsEvaluating)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_InitState_EvaluateActor);
+
+	Entry->bIsEvaluating = true;
+
+	auto NumPasses{ 0 };
+
+	for (; NumPasses < InitStateMaxEvaluationPasses; ++NumPasses)
+	{
+		// Find again every pass, since the callbacks may add entries for other actors
+
+		Entry = ActorEntries.Find(Actor);
+
+		if (!Entry || Entry->DirtyFeatures.IsEmpty())
+		{
+			break;
+		}
+
+		auto Features{ MoveTemp(Entry->DirtyFeatures) };
+		Entry->DirtyFeatures.Reset();
+
+		// The InitState feature of the actor gates the other features, so evaluate it first
+
+		Features.StableSort(
+			[](const TWeakObjectPtr<UActorComponent>& A, const TWeakObjectPtr<UActorComponent>& B)
+			{
+				return A.Get() && A->IsA<UInitStateComponent>() && !(B.Get() && B->IsA<UInitStateComponent>());
+			}
+		);
+
+		for (const auto& Feature : Features)
+		{
+			if (auto* Interface{ Cast<IGameFrameworkInitStateInterface>(Feature.Get()) })
+			{
+				INC_DWORD_STAT(STAT_InitState_NumEvaluations);
+				++NumEvaluations;
+
+				Interface->CheckDefaultInitialization();
+			}
+		}
+	}
+
+	Entry = ActorEntries.Find(Actor);
+
+	if (!Entry)
+	{
+		return;
+	}
+
+	Entry->bIsEvaluating = false;
+
+	// Keep the features that are still dirty and continue in the next tick instead of dropping them
+
+	if (!Entry->DirtyFeatures.IsEmpty())
+	{
+		UE_LOG(LogGameCore_InitState, Warning, TEXT("InitStateSubsystem: Features of [%s] kept changing after %d passes, continuing in the next tick"), *GetNameSafe(Actor), NumPasses);
+
+		AddPendingActor(Actor, *Entry);
+	}
+	else if (!Entry->bIsPending)
+	{
+		ActorEntries.Remove(Actor);
+	}
+}
+
+void UInitStateSubsystem::AddPendingActor(AActor* Actor, FActorEntry& Entry)
+{
+	if (!Entry.bIsPending)
+	{
+		Entry.bIsPending = true;
+
+		PendingActors.Add(Actor);
+	}
+}
+
+void UInitStateSubsystem::RemoveDirtyFeature(AActor* Actor, UActorComponent* Feature)
+{
+	auto* Entry{ ActorEntries.Find(Actor) };
+
+	if (!Entry)
+	{
+		return;
+	}
+
+	Entry->DirtyFeatures.Remove(Feature);
+
+	// The running evaluation removes the entry itself when it finishes
+
+	if (Entry->DirtyFeatures.IsEmpty() && !Entry->bIsEvaluating)
+	{
+		if (Entry->bIsPending)
+		{
+			PendingActors.Remove(Actor);
+		}
+
+		ActorEntries.Remove(Actor);
+	}
+}
+
+void UInitStateSubsystem::CancelActor(AActor* Actor)
+{
+	auto* Entry{ ActorEntries.Find(Actor) };
+
+	if (!Entry)
+	{
+		return;
+	}
+
+	Entry->DirtyFeatures.Reset();
+
+	if (!Entry->bIsEvaluating)
+	{
+		if (Entry->bIsPending)
+		{
+			PendingActors.Remove(Actor);
+		}
+
+		ActorEntries.Remove(Actor);
+	}
+}
+
+void UInitStateSubsystem::FlushPendingActors()
+{
+	// Actors marked while flushing are evaluated in the next tick
+
+	const auto Actors{ MoveTemp(PendingActors) };
+	PendingActors.Reset();
+
+	for (const auto& Actor : Actors)
+	{
+		if (auto* Entry{ ActorEntries.Find(Actor) })
+		{
+			Entry->bIsPending = false;
+		}
+
+		if (auto* StrongActor{ Actor.Get() })
+		{
+			EvaluateActor(StrongActor);
+		}
+		else
+		{
+			ActorEntries.Remove(Actor);
+		}
+	}
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// Dependencies
+
+#pragma region Dependencies
+
+bool UInitStateSubsystem::RegisterFeature(UActorComponent* Feature, FName FeatureName)
+{
+	check(Feature);
+
+	const auto* World{ Feature->GetWorld() };
+	auto* Subsystem{ World ? World->GetSubsystem<UInitStateSubsystem>() : nullptr };
+	auto* Actor{ Feature->GetOwner() };
+	auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+	if (!Subsystem || !Manager)
+	{
+		return false;
+	}
+
+	auto& Bound{ Subsystem->BoundActors.FindOrAdd(Actor) };
+
+	// Listen to the actor once for all of its features
+
+	if (!Bound.InitStateChangedHandle.IsValid())
+	{
+		Bound.SpawnTime = FPlatformTime::Seconds();
+
+		Bound.InitStateChangedHandle = Manager->RegisterAndCallForActorInitState(Actor, NAME_None, FGameplayTag(),
+			FActorInitStateChangedDelegate::CreateUObject(Subsystem, &ThisClass::HandleActorInitStateChanged), false);
+	}
+
+	Bound.Features.Emplace(FeatureName, Feature);
+
+	return true;
+}
+
+void UInitStateSubsystem::UnregisterFeature(UActorComponent* Feature, FName FeatureName)
+{
+	check(Feature);
+
+	const auto* World{ Feature->GetWorld() };
+	auto* Subsystem{ World ? World->GetSubsystem<UInitStateSubsystem>() : nullptr };
+	auto* Actor{ Feature->GetOwner() };
+
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	// Drop the pending check of the feature so that it is not evaluated after it has been rewound (e.g. released to a pool)
+
+	Subsystem->RemoveDirtyFeature(Actor, Feature);
+
+	auto* Bound{ Subsystem->BoundActors.Find(Actor) };
+
+	if (!Bound)
+	{
+		return;
+	}
+
+	Bound->Features.RemoveAll(
+		[Feature](const TPair<FName, TWeakObjectPtr<UActorComponent>>& Entry)
+		{
+			return !Entry.Value.IsValid() || (Entry.Value.Get() == Feature);
+		}
+	);
+
+	// Stop listening once the last feature of the actor is gone
+
+	if (Bound->Features.IsEmpty())
+	{
+		if (auto* Manager{ UGameFrameworkComponentManager::GetForActor(Actor) })
+		{
+			Manager->UnregisterActorInitStateDelegate(Actor, Bound->InitStateChangedHandle);
+		}
+
+		Subsystem->BoundActors.Remove(Actor);
+	}
+}
+
+bool UInitStateSubsystem::ShouldWakeFeature(const UActorComponent* Feature, FName FeatureName, const FActorInitStateChangedParams& Params)
+{
+	check(Feature);
+
+	auto* Actor{ Feature->GetOwner() };
+	auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+	if (!Manager)
+	{
+		return false;
+	}
+
+	// Features registered with the subsystem are already woken up by it
+
+	const auto* World{ Feature->GetWorld() };
+	const auto* Subsystem{ World ? World->GetSubsystem<UInitStateSubsystem>() : nullptr };
+
+	if (Subsystem && Subsystem->IsFeatureRegistered(Actor, Feature))
+	{
+		return false;
+	}
+
+	return FInitStateDependencyGraph::Get(Actor->GetClass()).ShouldWakeFeature(Manager, FeatureName, Params);
+}
+
+void UInitStateSubsystem::CheckUnregisteredImplementers(UActorComponent* Feature, FName FeatureName)
+{
+	check(Feature);
+
+	const auto* World{ Feature->GetWorld() };
+	const auto* Subsystem{ World ? World->GetSubsystem<UInitStateSubsystem>() : nullptr };
+	auto* Actor{ Feature->GetOwner() };
+	auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+	if (!Manager)
+	{
+		return;
+	}
+
+	TArray<UObject*> Implementers;
+	Manager->GetAllFeatureImplementers(Implementers, Actor, FGameplayTag(), FeatureName);
+
+	for (auto* Implementer : Implementers)
+	{
+		if (Subsystem && Subsystem->IsFeatureRegistered(Actor, Implementer))
+		{
+			continue;
+		}
+
+		if (auto* Interface{ Cast<IGameFrameworkInitStateInterface>(Implementer) })
+		{
+			Interface->CheckDefaultInitialization();
+		}
+	}
+}
+
+bool UInitStateSubsystem::IsFeatureRegistered(const AActor* Actor, const UObject* Feature) const
+{
+	const auto* Bound{ BoundActors.Find(Actor) };
+
+	return Bound && Bound->Features.ContainsByPredicate(
+		[Feature](const TPair<FName, TWeakObjectPtr<UActorComponent>>& Entry)
+		{
+			return Entry.Value.Get() == Feature;
+		}
+	);
+}
+
+void UInitStateSubsystem::FastForwardFeature(UActorComponent* Feature, FName FeatureName, FGameplayTag TargetState)
+{
+	check(Feature);
+
+	auto* Actor{ Feature->GetOwner() };
+	auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+	if (!Manager)
+	{
+		return;
+	}
+
+	const auto& Table{ FInitStateTransitionTable::Get() };
+	const auto& StateChain{ Table.GetStateChain() };
+	const auto TargetIndex{ Table.GetStateIndex(TargetState) };
+	const auto& Graph{ FInitStateDependencyGraph::Get(Actor->GetClass()) };
+
+	// Each state is still entered in order so that the dependents are notified.
+	// Stop at the first state whose dependencies are not met yet, the feature continues through the chain normally when it is woken up.
+	// e.g. the InitState feature stops at [DataAvailable] until the other features have been fast-forwarded to [DataInitialized]
+
+	for (auto Index{ Table.GetStateIndex(Manager->GetInitStateForFeature(Actor, FeatureName)) + 1 }; Index <= TargetIndex; ++Index)
+	{
+		if (!Graph.AreDependenciesMet(Manager, Actor, FeatureName, StateChain[Index]))
+		{
+			break;
+		}
+
+		Manager->ChangeFeatureInitState(Actor, FeatureName, Feature, StateChain[Index]);
+	}
+}
+
+void UInitStateSubsystem::HandleActorInitStateChanged(const FActorInitStateChangedParams& Params)
+{
+	auto* Actor{ Params.OwningActor };
+	auto* Bound{ BoundActors.Find(Actor) };
+	auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+	if (!Bound || !Manager)
+	{
+		return;
+	}
+
+	RecordStateTime(*Bound, Manager, Params);
+
+	TArray<FName, TInlineAllocator<8>> FeaturesToWake;
+	FInitStateDependencyGraph::Get(Actor->GetClass()).GetFeaturesToWake(Manager, Params, FeaturesToWake);
+
+	// Copy the features, since the callbacks and the evaluation may unregister features
+
+	TArray<TWeakObjectPtr<UActorComponent>, TInlineAllocator<8>> Features;
+	TArray<TWeakObjectPtr<UActorComponent>, TInlineAllocator<8>> WokenFeatures;
+
+	for (const auto& Entry : Bound->Features)
+	{
+		Features.Add(Entry.Value);
+
+		if (FeaturesToWake.Contains(Entry.Key))
+		{
+			WokenFeatures.Add(Entry.Value);
+		}
+	}
+
+	// Every feature still receives the change as if it were bound with BindOnActorInitStateChanged
+
+	for (const auto& Feature : Features)
+	{
+		if (auto* Interface{ Cast<IGameFrameworkInitStateInterface>(Feature.Get()) })
+		{
+			Interface->OnActorInitStateChanged(Params);
+		}
+	}
+
+	// Only the features whose dependencies were satisfied are evaluated
+
+	for (const auto& Feature : WokenFeatures)
+	{
+		if (auto* Component{ Feature.Get() })
+		{
+			INC_DWORD_STAT(STAT_InitState_NumDependencyWakes);
+			++NumDependencyWakes;
+
+			MarkFeatureDirty(Component);
+		}
+	}
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// Timing
+
+#pragma region Timing
+
+const double FInitStateLatencyHistogram::BucketUpperBoundsMs[NumBuckets]
+{
+	1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 500.0, 1000.0, 5000.0, TNumericLimits<double>::Max()
+};
+
+void FInitStateLatencyHistogram::Add(double LatencyMs)
+{
+	auto BucketIndex{ 0 };
+
+	while ((BucketIndex < NumBuckets - 1) && (LatencyMs > BucketUpperBoundsMs[BucketIndex]))
+	{
+		++BucketIndex;
+	}
+
+	++Buckets[BucketIndex];
+	++Count;
+	TotalMs += LatencyMs;
+	MaxMs = FMath::Max(MaxMs, LatencyMs);
+}
+
+FString FInitStateLatencyHistogram::ToString() const
+{
+	auto Result{ FString::Printf(TEXT("Count: %u, Avg: %.2fms, Max: %.2fms |"), Count, (Count > 0) ? (TotalMs / Count) : 0.0, MaxMs) };
+
+	for (auto BucketIndex{ 0 }; BucketIndex < NumBuckets; ++BucketIndex)
+	{
+		if (BucketIndex < NumBuckets - 1)
+		{
+			Result += FString::Printf(TEXT(" <=%.0fms: %u"), BucketUpperBoundsMs[BucketIndex], Buckets[BucketIndex]);
+		}
+		else
+		{
+			Result += FString::Printf(TEXT(" >%.0fms: %u"), BucketUpperBoundsMs[BucketIndex - 1], Buckets[BucketIndex]);
+		}
+	}
+
+	return Result;
+}
+
+
+void UInitStateSubsystem::RecordStateTime(FBoundActor& Bound, UGameFrameworkComponentManager* Manager, const FActorInitStateChangedParams& Params)
+{
+	const auto Time{ FPlatformTime::Seconds() - Bound.SpawnTime };
+
+	Bound.StateTimes.Add({ Params.FeatureName, Params.FeatureState, Time });
+
+	// The actor is ready when all of its features have reached the last state of the chain
+
+	const auto& StateChain{ FInitStateTransitionTable::Get().GetStateChain() };
+
+	if (!Bound.bReachedLastState && (Params.FeatureState == StateChain.Last()) && Manager->HaveAllFeaturesReachedInitState(Params.OwningActor, StateChain.Last()))
+	{
+		Bound.bReachedLastState = true;
+
+		LatencyHistograms.FindOrAdd(Params.OwningActor->GetClass()).Add(Time * 1000.0);
+
+		UE_LOG(LogGameCore_InitState, Verbose, TEXT("[%s] reached [%s] in %.2fms"), *GetNameSafe(Params.OwningActor), *StateChain.Last().ToString(), Time * 1000.0);
+	}
+}
+
+void UInitStateSubsystem::CheckStuckActors()
+{
+	const auto Now{ FPlatformTime::Seconds() };
+	const auto& LastState{ FInitStateTransitionTable::Get().GetStateChain().Last() };
+
+	for (auto& KVP : BoundActors)
+	{
+		auto& Bound{ KVP.Value };
+
+		if (Bound.bReachedLastState || Bound.bReportedStuck || ((Now - Bound.SpawnTime) < WatchdogBudget))
+		{
+			continue;
+		}
+
+		auto* Actor{ KVP.Key.Get() };
+		auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+		if (!Manager)
+		{
+			continue;
+		}
+
+		Bound.bReportedStuck = true;
+
+		UE_LOG(LogGameCore_InitState, Warning, TEXT("[%s] has not reached [%s] after %.2fs, blocked by: %s"),
+			*GetNameSafe(Actor), *LastState.ToString(), Now - Bound.SpawnTime, *GetBlockingFeatures(Actor, Bound, Manager, LastState));
+	}
+}
+
+FString UInitStateSubsystem::GetBlockingFeatures(AActor* Actor, const FBoundActor& Bound, UGameFrameworkComponentManager* Manager, FGameplayTag State) const
+{
+	// Collect every feature known for the actor, not only the ones registered with the subsystem:
+	// the features reported by the manager so far, and the components or actor implementing the init state interface (including third-party features)
+
+	TArray<FName, TInlineAllocator<16>> FeatureNames;
+
+	for (const auto& Feature : Bound.Features)
+	{
+		FeatureNames.AddUnique(Feature.Key);
+	}
+
+	for (const auto& StateTime : Bound.StateTimes)
+	{
+		FeatureNames.AddUnique(StateTime.Feature);
+	}
+
+	if (const auto* ActorInterface{ Cast<IGameFrameworkInitStateInterface>(Actor) })
+	{
+		FeatureNames.AddUnique(ActorInterface->GetFeatureName());
+	}
+
+	Actor->ForEachComponent(false,
+		[&FeatureNames](UActorComponent* Component)
+		{
+			if (const auto* Interface{ Cast<IGameFrameworkInitStateInterface>(Component) })
+			{
+				FeatureNames.AddUnique(Interface->GetFeatureName());
+			}
+		}
+	);
+
+	FString Result;
+
+	for (const auto& FeatureName : FeatureNames)
+	{
+		if (!Manager->HasFeatureReachedInitState(Actor, FeatureName, State))
+		{
+			Result += FString::Printf(TEXT("%s%s [%s]"), Result.IsEmpty() ? TEXT("") : TEXT(", "), *FeatureName.ToString(), *Manager->GetInitStateForFeature(Actor, FeatureName).ToString());
+		}
+	}
+
+	// The manager may also know features that never changed their state and are not implemented by the actor or its components
+
+	if (Result.IsEmpty() && !Manager->HaveAllFeaturesReachedInitState(Actor, State))
+	{
+		Result = TEXT("features registered to the manager without a state");
+	}
+
+	return Result;
+}
+
+const TArray<FInitStateFeatureTime>* UInitStateSubsystem::GetStateTimes(const AActor* Actor) const
+{
+	const auto* Bound{ BoundActors.Find(Actor) };
+
+	return Bound ? &Bound->StateTimes : nullptr;
+}
+
+const FInitStateLatencyHistogram* UInitStateSubsystem::GetLatencyHistogram(const UClass* ActorClass) const
+{
+	return LatencyHistograms.Find(ActorClass);
+}
+
+void UInitStateSubsystem::DumpTimings() const
+{
+	UE_LOG(LogGameCore_InitState, Log, TEXT("Spawn to ready latency by class:"));
+
+	for (const auto& KVP : LatencyHistograms)
+	{
+		UE_LOG(LogGameCore_InitState, Log, TEXT("  %s: %s"), *GetNameSafe(KVP.Key.Get()), *KVP.Value.ToString());
+	}
+
+	const auto& LastState{ FInitStateTransitionTable::Get().GetStateChain().Last() };
+
+	UE_LOG(LogGameCore_InitState, Log, TEXT("Actors waiting for [%s]:"), *LastState.ToString());
+
+	for (const auto& KVP : BoundActors)
+	{
+		auto* Actor{ KVP.Key.Get() };
+		auto* Manager{ Actor ? UGameFrameworkComponentManager::GetForActor(Actor) : nullptr };
+
+		if (!Manager || KVP.Value.bReachedLastState)
+		{
+			continue;
+		}
+
+		UE_LOG(LogGameCore_InitState, Log, TEXT("  %s (%.2fs), blocked by: %s"),
+			*GetNameSafe(Actor), FPlatformTime::Seconds() - KVP.Value.SpawnTime, *GetBlockingFeatures(Actor, KVP.Value, Manager, LastState));
+
+		for (const auto& StateTime : KVP.Value.StateTimes)
+		{
+			UE_LOG(LogGameCore_InitState, Log, TEXT("    %.2fms %s -> %s"), StateTime.Time * 1000.0, *StateTime.Feature.ToString(), *StateTime.State.ToString());
+		}
+	}
+}
+
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorld CCmdInitStateDumpTimings(
+	TEXT("InitState.DumpTimings"),
+	TEXT("Logs the spawn to ready latency histogram of each actor class and the state timeline of the actors that are not ready yet"),
+	FConsoleCommandWithWorldDelegate::CreateLambda(
+		[](UWorld* World)
+		{
+			if (const auto* Subsystem{ World ? World->GetSubsystem<UInitStateSubsystem>() : nullptr })
+			{
+				Subsystem->DumpTimings();
+			}
+		}));
+
+#endif
+
+#pragma endregion
@@ -0,0 +1,307 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GameplayTagContainer.h"
+
+#include "InitStateSubsystem.generated.h"
+
+class UActorComponent;
+struct FActorInitStateChangedParams;
+
+
+/**
+ * Time at which a feature of an actor entered a state
+ */
+struct GFCORE_API FInitStateFeatureTime
+{
+public:
+	FName Feature;
+	FGameplayTag State;
+
+	//
+	// Seconds since the first feature of the actor was registered
+	//
+	double Time{ 0.0 };
+};
+
+
+/**
+ * Histogram of the latency from the registration of the first feature of an actor until all of its features reach
+ * the last state of the init state chain
+ */
+struct GFCORE_API FInitStateLatencyHistogram
+{
+public:
+	static constexpr int32 NumBuckets{ 12 };
+
+	//
+	// Upper bound of each bucket in milliseconds (the last bucket has no upper bound)
+	//
+	static const double BucketUpperBoundsMs[NumBuckets];
+
+	uint32 Buckets[NumBuckets]{};
+	uint32 Count{ 0 };
+	double TotalMs{ 0.0 };
+	double MaxMs{ 0.0 };
+
+public:
+	void Add(double LatencyMs);
+
+	FString ToString() const;
+};
+
+
+/**
+ * Subsystem that schedules the init state chain evaluation of the features of each actor
+ * 
+ * Tips:
+ *	Features request a check with RequestCheckDefaultInitialization instead of calling CheckDefaultInitialization directly.
+ *	Requests for a feature that is already pending are merged, and the pending features of an actor are evaluated
+ *	together in dependency order (the InitState feature of the actor first), so state changes during the evaluation
+ *	only mark features dirty instead of recursing into every feature.
+ *	If bDeferInitStateEvaluation is enabled in UGameFrameworkDeveloperSettings, the evaluation runs once per frame.
+ */
+UCLASS()
+class GFCORE_API UInitStateSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	UInitStateSubsystem() {}
+
+	///////////////////////////////////////////////////////////
+	// Subsystem
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return !PendingActors.IsEmpty() || ((WatchdogBudget > 0.0f) && !BoundActors.IsEmpty()); }
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+
+	///////////////////////////////////////////////////////////
+	// Scheduling
+protected:
+	/**
+	 * Features of an actor waiting to be evaluated
+	 */
+	struct FActorEntry
+	{
+		TArray<TWeakObjectPtr<UActorComponent>, TInlineAllocator<8>> DirtyFeatures;
+		bool bIsEvaluating{ false };
+
+		// Whether the actor is in PendingActors
+		bool bIsPending{ false };
+	};
+
+	//
+	// Actors that have features waiting to be evaluated or are being evaluated
+	//
+	TMap<TWeakObjectPtr<AActor>, FActorEntry> ActorEntries;
+
+	//
+	// Actors to be evaluated in the next tick (when the evaluation is deferred or ran out of passes)
+	//
+	TArray<TWeakObjectPtr<AActor>> PendingActors;
+
+	//
+	// Whether the evaluation is deferred to once per frame
+	//
+	bool bDeferEvaluation{ true };
+
+	//
+	// Number of evaluations executed and requests merged into a pending evaluation since the subsystem was created
+	//
+	uint64 NumEvaluations{ 0 };
+	uint64 NumMergedRequests{ 0 };
+
+public:
+	/**
+	 * Request the init state chain of the feature to be checked
+	 * 
+	 * Tips:
+	 *	Calls CheckDefaultInitialization directly if the world of the feature has no scheduler (e.g. editor worlds).
+	 */
+	static void RequestCheckDefaultInitialization(UActorComponent* Feature);
+
+	/**
+	 * Mark the feature to be evaluated with the other pending features of its actor
+	 */
+	void MarkFeatureDirty(UActorComponent* Feature);
+
+	/**
+	 * Evaluate all pending features of the actor until none of them changes its state
+	 * 
+	 * Tips:
+	 *	If the features are still dirty after the maximum number of passes, the actor is evaluated again in the next tick.
+	 */
+	void EvaluateActor(AActor* Actor);
+
+	/**
+	 * Discard the pending checks of all features of the actor
+	 * 
+	 * Tips:
+	 *	Used when the actor is released to a pool, so that its rewound features are not evaluated while it is in the pool.
+	 */
+	void CancelActor(AActor* Actor);
+
+protected:
+	/**
+	 * Add the actor to the actors evaluated in the next tick
+	 */
+	void AddPendingActor(AActor* Actor, FActorEntry& Entry);
+
+	/**
+	 * Discard the pending check of the feature, and the entry of its actor if it was the last one
+	 */
+	void RemoveDirtyFeature(AActor* Actor, UActorComponent* Feature);
+
+public:
+	/**
+	 * Evaluate all actors with pending features
+	 */
+	void FlushPendingActors();
+
+	uint64 GetNumEvaluations() const { return NumEvaluations; }
+	uint64 GetNumMergedRequests() const { return NumMergedRequests; }
+
+
+	///////////////////////////////////////////////////////////
+	// Dependencies
+protected:
+	/**
+	 * Actor whose init state changes are dispatched to its features through the dependency graph
+	 */
+	struct FBoundActor
+	{
+		FDelegateHandle InitStateChangedHandle;
+		TArray<TPair<FName, TWeakObjectPtr<UActorComponent>>, TInlineAllocator<8>> Features;
+
+		// Timing
+
+		double SpawnTime{ 0.0 };
+		TArray<FInitStateFeatureTime> StateTimes;
+		bool bReachedLastState{ false };
+		bool bReportedStuck{ false };
+	};
+
+	//
+	// Actors listened to by the subsystem
+	//
+	TMap<TWeakObjectPtr<AActor>, FBoundActor> BoundActors;
+
+	//
+	// Number of features woken up by a satisfied dependency since the subsystem was created
+	//
+	uint64 NumDependencyWakes{ 0 };
+
+public:
+	/**
+	 * Register the feature to be woken up when the dependencies declared in FInitStateDependencyGraph are satisfied
+	 * 
+	 * Tips:
+	 *	Every init state change of the actor is still forwarded to OnActorInitStateChanged of the feature.
+	 *	Returns false if the world of the feature has no scheduler. 
+	 *	In that case the feature should listen to the state changes itself and filter them with ShouldWakeFeature.
+	 */
+	static bool RegisterFeature(UActorComponent* Feature, FName FeatureName);
+
+	/**
+	 * Unregister the feature registered with RegisterFeature
+	 */
+	static void UnregisterFeature(UActorComponent* Feature, FName FeatureName);
+
+	/**
+	 * Returns whether the state change satisfied the dependencies of the feature
+	 * 
+	 * Tips:
+	 *	Returns false for features registered with RegisterFeature, since the subsystem wakes them up itself.
+	 */
+	static bool ShouldWakeFeature(const UActorComponent* Feature, FName FeatureName, const FActorInitStateChangedParams& Params);
+
+	/**
+	 * Check the init state chain of the other features of the actor that are not registered with the subsystem
+	 * 
+	 * Tips:
+	 *	Features registered with RegisterFeature are woken up through the dependency graph instead,
+	 *	but third-party IGameFrameworkInitStateInterface features still rely on being checked when the InitState feature is.
+	 */
+	static void CheckUnregisteredImplementers(UActorComponent* Feature, FName FeatureName);
+
+	/**
+	 * Move the feature through the chain up to the target state without the checks and handlers of the feature
+	 * 
+	 * Tips:
+	 *	Used to restore a feature reacquired from a pool whose data is still valid.
+	 *	The declared dependencies are still respected, so the feature stops at the first state whose dependencies are not met.
+	 */
+	static void FastForwardFeature(UActorComponent* Feature, FName FeatureName, FGameplayTag TargetState);
+
+	uint64 GetNumDependencyWakes() const { return NumDependencyWakes; }
+
+protected:
+	/**
+	 * Returns whether the object is a feature registered with RegisterFeature
+	 */
+	bool IsFeatureRegistered(const AActor* Actor, const UObject* Feature) const;
+
+	void HandleActorInitStateChanged(const FActorInitStateChangedParams& Params);
+
+
+	///////////////////////////////////////////////////////////
+	// Timing
+protected:
+	//
+	// Spawn to ready latency by actor class
+	//
+	TMap<TWeakObjectPtr<UClass>, FInitStateLatencyHistogram> LatencyHistograms;
+
+	//
+	// Seconds an actor may take to reach the last state before it is reported as stuck (0 to disable)
+	//
+	float WatchdogBudget{ 0.0f };
+
+	//
+	// Seconds since the watchdog last checked the actors
+	//
+	float WatchdogElapsed{ 0.0f };
+
+public:
+	/**
+	 * Returns the times at which the features of the actor entered their states
+	 */
+	const TArray<FInitStateFeatureTime>* GetStateTimes(const AActor* Actor) const;
+
+	/**
+	 * Returns the spawn to ready latency histogram of the actor class
+	 */
+	const FInitStateLatencyHistogram* GetLatencyHistogram(const UClass* ActorClass) const;
+
+	/**
+	 * Log the latency histograms and the actors that have not reached the last state yet
+	 */
+	void DumpTimings() const;
+
+protected:
+	void RecordStateTime(FBoundActor& Bound, UGameFrameworkComponentManager* Manager, const FActorInitStateChangedParams& Params);
+
+	/**
+	 * Report the actors that exceeded the watchdog budget with the features blocking them
+	 */
+	void CheckStuckActors();
+
+	/**
+	 * Returns the features of the actor that have not reached the state, with their current state
+	 * 
+	 * Tips:
+	 *	Includes the features not registered with the subsystem, such as third-party IGameFrameworkInitStateInterface features.
+	 */
+	FString GetBlockingFeatures(AActor* Actor, const FBoundActor& Bound, UGameFrameworkComponentManager* Manager, FGameplayTag State) const;
+
+};
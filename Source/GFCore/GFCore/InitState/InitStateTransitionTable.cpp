@@ -0,0 +1,150 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "InitState/InitStateTransitionTable.h"
+
+#include "InitState/InitStateTags.h"
+#include "GameFrameworkDeveloperSettings.h"
+#include "GFCoreLogs.h"
+
+
+//
+// Table shared by all features
+//
+static TUniquePtr<FInitStateTransitionTable> InitStateTransitionTable;
+
+//
+// Tables replaced by Rebuild, kept alive since callers may still hold references returned by Get()
+//
+static TArray<TUniquePtr<FInitStateTransitionTable>> RetiredInitStateTransitionTables;
+
+
+const FInitStateTransitionTable& FInitStateTransitionTable::Get()
+{
+	if (!InitStateTransitionTable.IsValid())
+	{
+		Rebuild();
+	}
+
+	return *InitStateTransitionTable;
+}
+
+void FInitStateTransitionTable::Rebuild()
+{
+	check(IsInGameThread());
+
+	static const TArray<FGameplayTag> DefaultStateChain
+	{
+		TAG_InitState_Spawned,
+		TAG_InitState_DataAvailable,
+		TAG_InitState_DataInitialized,
+		TAG_InitState_GameplayReady
+	};
+
+	const auto& ConfigStateChain{ GetDefault<UGameFrameworkDeveloperSettings>()->InitStateChain };
+
+	auto NewTable{ MakeUnique<FInitStateTransitionTable>() };
+
+	if (ConfigStateChain.IsEmpty())
+	{
+		NewTable->Compile(DefaultStateChain);
+	}
+	else if (IsValidStateChain(ConfigStateChain))
+	{
+		NewTable->Compile(ConfigStateChain);
+	}
+	else
+	{
+		UE_LOG(LogGameCore_InitState, Error, TEXT("InitStateChain in developer settings must start with [%s], contain each state once and keep the built-in states in order. Using the default chain."),
+			*TAG_InitState_Spawned.GetTag().ToString());
+
+		NewTable->Compile(DefaultStateChain);
+	}
+
+	// Keep the current table if the chain has not changed (e.g. another game instance of the same session)
+
+	if (InitStateTransitionTable.IsValid())
+	{
+		if (InitStateTransitionTable->StateChain == NewTable->StateChain)
+		{
+			return;
+		}
+
+		RetiredInitStateTransitionTables.Add(MoveTemp(InitStateTransitionTable));
+	}
+
+	InitStateTransitionTable = MoveTemp(NewTable);
+}
+
+void FInitStateTransitionTable::Compile(const TArray<FGameplayTag>& InStateChain)
+{
+	StateChain = InStateChain;
+
+	BuiltinStates.Reset(StateChain.Num());
+
+	for (const auto& State : StateChain)
+	{
+		if (State == TAG_InitState_Spawned)
+		{
+			BuiltinStates.Add(EInitStateBuiltin::Spawned);
+		}
+		else if (State == TAG_InitState_DataAvailable)
+		{
+			BuiltinStates.Add(EInitStateBuiltin::DataAvailable);
+		}
+		else if (State == TAG_InitState_DataInitialized)
+		{
+			BuiltinStates.Add(EInitStateBuiltin::DataInitialized);
+		}
+		else if (State == TAG_InitState_GameplayReady)
+		{
+			BuiltinStates.Add(EInitStateBuiltin::GameplayReady);
+		}
+		else
+		{
+			BuiltinStates.Add(EInitStateBuiltin::Custom);
+		}
+	}
+}
+
+bool FInitStateTransitionTable::IsValidStateChain(const TArray<FGameplayTag>& InStateChain)
+{
+	// Features try to enter [Spawned] on BeginPlay, so it must be the first state
+
+	if (InStateChain.IsEmpty() || (InStateChain[0] != TAG_InitState_Spawned))
+	{
+		return false;
+	}
+
+	// Built-in states are required by the built-in dependencies and must keep their order
+
+	auto LastBuiltinIndex{ INDEX_NONE };
+
+	for (const auto& BuiltinState : { TAG_InitState_DataAvailable.GetTag(), TAG_InitState_DataInitialized.GetTag(), TAG_InitState_GameplayReady.GetTag() })
+	{
+		const auto Index{ InStateChain.IndexOfByKey(BuiltinState) };
+
+		if (Index <= LastBuiltinIndex)
+		{
+			return false;
+		}
+
+		LastBuiltinIndex = Index;
+	}
+
+	// States must be valid and unique
+
+	TSet<FGameplayTag> UniqueStates;
+
+	for (const auto& State : InStateChain)
+	{
+		bool bIsAlreadyInSet{ false };
+		UniqueStates.Add(State, &bIsAlreadyInSet);
+
+		if (!State.IsValid() || bIsAlreadyInSet)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,103 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "GameplayTagContainer.h"
+
+
+/**
+ * Built-in states of the init state chain
+ */
+enum class EInitStateBuiltin : uint8
+{
+	Custom,
+	Spawned,
+	DataAvailable,
+	DataInitialized,
+	GameplayReady
+};
+
+
+/**
+ * Transition table compiled from the init state chain in UGameFrameworkDeveloperSettings
+ * 
+ * Tips:
+ *	The chain is shared by the GameFrameworkComponentManager registration and all init state features.
+ *	A feature can only move from a state to the next state of the chain, and the built-in states are resolved
+ *	to EInitStateBuiltin once so that features dispatch to their per-state hooks without comparing tags.
+ */
+class GFCORE_API FInitStateTransitionTable
+{
+public:
+	FInitStateTransitionTable() {}
+
+protected:
+	//
+	// States in the order they are reached
+	//
+	TArray<FGameplayTag> StateChain;
+
+	//
+	// Built-in state of each state in the chain
+	//
+	TArray<EInitStateBuiltin> BuiltinStates;
+
+public:
+	/**
+	 * Returns the table compiled from the current developer settings
+	 */
+	static const FInitStateTransitionTable& Get();
+
+	/**
+	 * Compile the table again from the developer settings
+	 * 
+	 * Tips:
+	 *	Called when a game instance is initialized, before the states are registered to the GameFrameworkComponentManager.
+	 *	The previous table is kept alive, so references returned by Get() remain valid.
+	 */
+	static void Rebuild();
+
+	/**
+	 * Returns the states in the order they are reached
+	 */
+	const TArray<FGameplayTag>& GetStateChain() const { return StateChain; }
+
+	/**
+	 * Returns the index of the state in the chain or INDEX_NONE
+	 */
+	int32 GetStateIndex(FGameplayTag State) const
+	{
+		return State.IsValid() ? StateChain.IndexOfByKey(State) : INDEX_NONE;
+	}
+
+	/**
+	 * Returns the index of the desired state if it is the next state of the current state, otherwise INDEX_NONE
+	 */
+	int32 FindTransition(FGameplayTag CurrentState, FGameplayTag DesiredState) const
+	{
+		const auto DesiredIndex{ GetStateIndex(DesiredState) };
+
+		if (DesiredIndex == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+
+		const auto bIsNext{ (DesiredIndex == 0) ? !CurrentState.IsValid() : (StateChain[DesiredIndex - 1] == CurrentState) };
+
+		return bIsNext ? DesiredIndex : INDEX_NONE;
+	}
+
+	/**
+	 * Returns the built-in state at the index of the chain
+	 */
+	EInitStateBuiltin GetBuiltinState(int32 StateIndex) const
+	{
+		return BuiltinStates.IsValidIndex(StateIndex) ? BuiltinStates[StateIndex] : EInitStateBuiltin::Custom;
+	}
+
+protected:
+	void Compile(const TArray<FGameplayTag>& InStateChain);
+
+	static bool IsValidStateChain(const TArray<FGameplayTag>& InStateChain);
+
+};
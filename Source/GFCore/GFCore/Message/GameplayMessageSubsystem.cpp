@@ -1,18 +1,38 @@
-// Copyright (C) 2024 owoDra
+﻿// Copyright (C) 2024 owoDra
 
 #include "GameplayMessageSubsystem.h"
 
+#include "GameplayTag/GameplayTagStackMessageTypes.h"
+#include "GameFrameworkDeveloperSettings.h"
 #include "GFCoreLogs.h"
 
 #include "Engine/Engine.h"
 #include "Engine/GameInstance.h"
 #include "Engine/World.h"
+#include "GameplayTagsManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/ScopeExit.h"
 #include "UObject/ScriptMacros.h"
 #include "UObject/Stack.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GameplayMessageSubsystem)
 
 
+DECLARE_STATS_GROUP(TEXT("GameplayMessage"), STATGROUP_GameplayMessage, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Broadcast Message"), STAT_GameplayMessage_Broadcast, STATGROUP_GameplayMessage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Broadcasts"), STAT_GameplayMessage_NumBroadcasts, STATGROUP_GameplayMessage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dispatch List Rebuilds"), STAT_GameplayMessage_NumDispatchListRebuilds, STATGROUP_GameplayMessage);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Dispatch Lists"), STAT_GameplayMessage_NumCachedDispatchLists, STATGROUP_GameplayMessage);
+DECLARE_CYCLE_STAT(TEXT("Flush Queued Messages"), STAT_GameplayMessage_FlushQueue, STATGROUP_GameplayMessage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Messages"), STAT_GameplayMessage_NumQueuedMessages, STATGROUP_GameplayMessage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Coalesced Messages"), STAT_GameplayMessage_NumCoalescedMessages, STATGROUP_GameplayMessage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Coalesced Messages Replaced"), STAT_GameplayMessage_NumCoalescedReplaced, STATGROUP_GameplayMessage);
+DECLARE_CYCLE_STAT(TEXT("Process Thread-Safe Messages"), STAT_GameplayMessage_ProcessThreadSafe, STATGROUP_GameplayMessage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Thread-Safe Messages Dropped"), STAT_GameplayMessage_NumThreadSafeDropped, STATGROUP_GameplayMessage);
+
+
 //////////////////////////////////////////////////////////////////////
 // FGameplayMessageListenerHandle
 
@@ -26,20 +46,102 @@ void FGameplayMessageListenerHandle::Unregister()
 		Subsystem.Reset();
 		Channel = FGameplayTag();
 		ID = 0;
+		bKeyed = false;
+		KeyObject = FObjectKey();
+		KeyTag = FGameplayTag();
 	}
 }
 
 #pragma endregion
 
 
+//////////////////////////////////////////////////////////////////////
+// FGameplayMessageFlushTickFunction
+
+#pragma region FGameplayMessageFlushTickFunction
+
+void FGameplayMessageFlushTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->ProcessThreadSafeMessages();
+		Target->FlushQueuedMessages();
+	}
+}
+
+FString FGameplayMessageFlushTickFunction::DiagnosticMessage()
+{
+	return TEXT("FGameplayMessageFlushTickFunction");
+}
+
+#pragma endregion
+
+
 //////////////////////////////////////////////////////////////////////
 // UGameplayMessageSubsystem
 
 #pragma region UGameplayMessageSubsystem
 
+void UGameplayMessageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const auto* DevSettings{ GetDefault<UGameFrameworkDeveloperSettings>() };
+
+	FlushTickFunction.Target = this;
+	FlushTickFunction.TickGroup = DevSettings->QueuedMessageTickGroup;
+	FlushTickFunction.bCanEverTick = true;
+	FlushTickFunction.bTickEvenWhenPaused = true;
+
+	MaxThreadSafeMessages = DevSettings->MaxThreadSafeMessages;
+	bAcceptThreadSafeMessages = true;
+
+	WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &ThisClass::HandleWorldInitializedActors);
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &ThisClass::HandleWorldCleanup);
+}
+
 void UGameplayMessageSubsystem::Deinitialize()
 {
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+
+	if (FlushTickFunction.IsTickFunctionRegistered())
+	{
+		FlushTickFunction.UnRegisterTickFunction();
+	}
+
+	ResetMessageQueue(MessageQueues[0]);
+	ResetMessageQueue(MessageQueues[1]);
+
+	// Stop accepting messages from other threads and wait for the broadcasts in progress,
+	// so that nothing is enqueued or calls the listeners after they are released
+
+	bAcceptThreadSafeMessages = false;
+
+	while (NumThreadSafeBroadcasters.load() > 0)
+	{
+		FPlatformProcess::Yield();
+	}
+
+	FThreadSafeMessage ThreadSafeMessage;
+	while (ThreadSafeMessageQueue.Dequeue(ThreadSafeMessage))
+	{
+		ThreadSafeMessage.StructType->DestroyStruct(ThreadSafeMessage.Payload);
+		FMemory::Free(ThreadSafeMessage.Payload);
+	}
+
+	NumThreadSafeMessages = 0;
+
+	{
+		FWriteScopeLock WriteLock(ThreadSafeListenerMapLock);
+		ThreadSafeListenerMap.Reset();
+	}
+
 	ListenerMap.Reset();
+	KeyedListenerMap.Reset();
+	DispatchMap.Reset();
+
+	SET_DWORD_STAT(STAT_GameplayMessage_NumCachedDispatchLists, 0);
 
 	Super::Deinitialize();
 }
@@ -51,7 +153,14 @@ void UGameplayMessageSubsystem::UnregisterListener(FGameplayMessageListenerHandl
 	{
 		check(Handle.Subsystem == this);
 
-		UnregisterListenerInternal(Handle.Channel, Handle.ID);
+		if (Handle.bKeyed)
+		{
+			UnregisterKeyedListenerInternal(FMessageKey{ Handle.Channel, Handle.KeyObject, Handle.KeyTag }, Handle.ID);
+		}
+		else
+		{
+			UnregisterListenerInternal(Handle.Channel, Handle.ID);
+		}
 	}
 	else
 	{
@@ -66,16 +175,38 @@ void UGameplayMessageSubsystem::UnregisterListenerInternal(FGameplayTag Channel,
 		auto MatchIndex
 		{
 			List->Listeners.IndexOfByPredicate(
-				[ID = HandleID](const FGameplayMessageListenerData& Other)
+				[ID = HandleID](const TSharedRef<const FGameplayMessageListenerData>& Other)
 				{
-					return Other.HandleID == ID;
+					return Other->HandleID == ID;
 				}
 			)
 		};
 
 		if (MatchIndex != INDEX_NONE)
 		{
+			const auto bWasAnyThread{ List->Listeners[MatchIndex]->DeliveryType == EGameplayMessageDelivery::AnyThread };
+			const auto MatchType{ List->Listeners[MatchIndex]->MatchType };
+
+			// Wait for the calls in progress on other threads, which check the flag while holding the lock
+
+			if (bWasAnyThread)
+			{
+				FWriteScopeLock WriteLock(ThreadSafeDispatchLock);
+				List->Listeners[MatchIndex]->bUnregistered = true;
+			}
+			else
+			{
+				List->Listeners[MatchIndex]->bUnregistered = true;
+			}
+
 			List->Listeners.RemoveAtSwap(MatchIndex);
+
+			InvalidateDispatchLists(Channel, MatchType);
+
+			if (bWasAnyThread)
+			{
+				RebuildThreadSafeListenerMap();
+			}
 		}
 
 		if (List->Listeners.Num() == 0)
@@ -85,18 +216,92 @@ void UGameplayMessageSubsystem::UnregisterListenerInternal(FGameplayTag Channel,
 	}
 }
 
-FGameplayMessageListenerHandle UGameplayMessageSubsystem::RegisterListenerInternal(FGameplayTag Channel, TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback, const UScriptStruct* StructType, EGameplayMessageMatch MatchType)
+FGameplayMessageListenerHandle UGameplayMessageSubsystem::RegisterListenerInternal(FGameplayTag Channel, TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback, const UScriptStruct* StructType, EGameplayMessageMatch MatchType, EGameplayMessageDelivery DeliveryType)
 {
 	auto& List{ ListenerMap.FindOrAdd(Channel) };
 
-	auto& Entry{ List.Listeners.AddDefaulted_GetRef() };
-	Entry.ReceivedCallback = MoveTemp(Callback);
-	Entry.ListenerStructType = StructType;
-	Entry.bHadValidType = StructType != nullptr;
-	Entry.HandleID = ++List.HandleID;
-	Entry.MatchType = MatchType;
+	auto Entry{ MakeShared<FGameplayMessageListenerData>() };
+	Entry->ReceivedCallback = MoveTemp(Callback);
+	Entry->ListenerStructType = StructType;
+	Entry->bHadValidType = StructType != nullptr;
+	Entry->HandleID = ++List.HandleID;
+	Entry->MatchType = MatchType;
+	Entry->DeliveryType = DeliveryType;
+	Entry->Channel = Channel;
 
-	return FGameplayMessageListenerHandle(this, Channel, Entry.HandleID);
+	List.Listeners.Add(Entry);
+
+	InvalidateDispatchLists(Channel, MatchType);
+
+	if (DeliveryType == EGameplayMessageDelivery::AnyThread)
+	{
+		RebuildThreadSafeListenerMap();
+	}
+
+	return FGameplayMessageListenerHandle(this, Channel, Entry->HandleID);
+}
+
+
+void UGameplayMessageSubsystem::UnregisterKeyedListenerInternal(const FMessageKey& Key, int32 HandleID)
+{
+	if (auto* List{ KeyedListenerMap.Find(Key) })
+	{
+		// Replace the list instead of modifying it, since broadcasts in progress may be holding it
+
+		auto NewList{ MakeShared<FChannelDispatchList>(**List) };
+
+		NewList->Listeners.RemoveAllSwap(
+			[HandleID](const TSharedRef<const FGameplayMessageListenerData>& Other)
+			{
+				if (Other->HandleID == HandleID)
+				{
+					Other->bUnregistered = true;
+					return true;
+				}
+
+				return false;
+			}
+		);
+
+		if (NewList->Listeners.Num() == 0)
+		{
+			KeyedListenerMap.Remove(Key);
+		}
+		else
+		{
+			*List = NewList;
+		}
+	}
+}
+
+FGameplayMessageListenerHandle UGameplayMessageSubsystem::RegisterKeyedListenerInternal(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback, const UScriptStruct* StructType)
+{
+	const auto Key{ FMessageKey{ Channel, FObjectKey(KeyObject), KeyTag } };
+
+	// Handle IDs are unique across all keys, since the list of a key is removed when it becomes empty
+
+	auto Entry{ MakeShared<FGameplayMessageListenerData>() };
+	Entry->ReceivedCallback = MoveTemp(Callback);
+	Entry->ListenerStructType = StructType;
+	Entry->bHadValidType = StructType != nullptr;
+	Entry->HandleID = ++KeyedListenerHandleID;
+	Entry->MatchType = EGameplayMessageMatch::ExactMatch;
+	Entry->DeliveryType = EGameplayMessageDelivery::Immediate;
+	Entry->Channel = Channel;
+	Entry->bKeyed = true;
+	Entry->KeyObject = Key.Object;
+	Entry->KeyTag = KeyTag;
+
+	// Replace the list instead of modifying it, since broadcasts in progress may be holding it
+
+	const auto* List{ KeyedListenerMap.Find(Key) };
+
+	auto NewList{ List ? MakeShared<FChannelDispatchList>(**List) : MakeShared<FChannelDispatchList>() };
+	NewList->Listeners.Add(Entry);
+
+	KeyedListenerMap.Add(Key, NewList);
+
+	return FGameplayMessageListenerHandle(this, Channel, Key.Object, KeyTag, Entry->HandleID);
 }
 
 
@@ -123,52 +328,584 @@ DEFINE_FUNCTION(UGameplayMessageSubsystem::execK2_BroadcastMessage)
 	}
 }
 
-void UGameplayMessageSubsystem::BroadcastMessageInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes)
+void UGameplayMessageSubsystem::BroadcastMessageInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes, bool bSkipAnyThreadListeners)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GameplayMessage_Broadcast);
+	INC_DWORD_STAT(STAT_GameplayMessage_NumBroadcasts);
+
+	// Hold a reference to the dispatch list in case there are registrations or removals while handling callbacks.
+	// The cached list is only replaced in that case, so no allocation is made here.
+
+	const auto DispatchList{ FindOrBuildDispatchList(Channel) };
+
+	if (!DispatchList.IsValid())
+	{
+		return;
+	}
+
 	// Broadcast the message
 
-	auto bOnInitialTag{ true };
+	for (const auto& Listener : DispatchList->Listeners)
+	{
+		const auto bShouldInvoke
+		{
+			(Listener->DeliveryType == EGameplayMessageDelivery::Immediate) ||
+			((Listener->DeliveryType == EGameplayMessageDelivery::AnyThread) && !bSkipAnyThreadListeners)
+		};
 
-	for (auto Tag{ Channel }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+		if (bShouldInvoke)
+		{
+			InvokeListener(*Listener, Channel, StructType, MessageBytes);
+		}
+	}
+
+	// Queue a copy of the message for the listeners with Queued delivery
+
+	if (DispatchList->NumQueuedListeners > 0)
 	{
-		if (const auto* List{ ListenerMap.Find(Tag) })
+		EnqueueMessage(Channel, StructType, MessageBytes, DispatchList);
+	}
+}
+
+void UGameplayMessageSubsystem::BroadcastMessageKeyedInternal(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, const UScriptStruct* StructType, const void* MessageBytes)
+{
+	BroadcastMessageInternal(Channel, StructType, MessageBytes);
+
+	InvokeKeyedListeners(Channel, FObjectKey(KeyObject), KeyTag, StructType, MessageBytes);
+}
+
+void UGameplayMessageSubsystem::InvokeKeyedListeners(FGameplayTag Channel, FObjectKey KeyObject, FGameplayTag KeyTag, const UScriptStruct* StructType, const void* MessageBytes)
+{
+	if (KeyedListenerMap.IsEmpty())
+	{
+		return;
+	}
+
+	// Listeners of the object and tag, of the object with any tag, of the tag with any object, and of any object and any tag
+
+	const FMessageKey Keys[]
+	{
+		FMessageKey{ Channel, KeyObject, KeyTag },
+		FMessageKey{ Channel, KeyObject, FGameplayTag() },
+		FMessageKey{ Channel, FObjectKey(), KeyTag },
+		FMessageKey{ Channel, FObjectKey(), FGameplayTag() },
+	};
+
+	for (auto KeyIndex{ 0 }; KeyIndex < UE_ARRAY_COUNT(Keys); ++KeyIndex)
+	{
+		// Skip keys that are the same as a previous one (when the message has no object or no tag)
+
+		auto bDuplicateKey{ false };
+
+		for (auto PrevIndex{ 0 }; PrevIndex < KeyIndex; ++PrevIndex)
+		{
+			bDuplicateKey |= (Keys[PrevIndex] == Keys[KeyIndex]);
+		}
+
+		if (bDuplicateKey)
+		{
+			continue;
+		}
+
+		const auto* List{ KeyedListenerMap.Find(Keys[KeyIndex]) };
+
+		if (!List)
+		{
+			continue;
+		}
+
+		// Hold a reference to the list in case there are registrations or removals while handling callbacks
+
+		const TSharedRef<const FChannelDispatchList> Listeners{ *List };
+
+		for (const auto& Listener : Listeners->Listeners)
+		{
+			InvokeListener(*Listener, Channel, StructType, MessageBytes);
+		}
+	}
+}
+
+void UGameplayMessageSubsystem::BroadcastMessageThreadSafeInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes)
+{
+	// Register as a broadcaster before checking whether messages are accepted, so that Deinitialize waits for this broadcast
+
+	++NumThreadSafeBroadcasters;
+
+	ON_SCOPE_EXIT
+	{
+		--NumThreadSafeBroadcasters;
+	};
+
+	if (!bAcceptThreadSafeMessages.load())
+	{
+		return;
+	}
+
+	// Call the listeners with AnyThread delivery inline on this thread
+
+	TSharedPtr<const FThreadSafeListenerMap> Listeners;
+	{
+		FReadScopeLock ReadLock(ThreadSafeListenerMapLock);
+		Listeners = ThreadSafeListenerMap;
+	}
+
+	if (Listeners.IsValid())
+	{
+		if (const auto* List{ Listeners->Find(Channel) })
 		{
-			// Copy in case there are removals while handling callbacks
+			// Hold the dispatch lock while calling the listeners so that unregistering waits for this call.
+			// Not needed on the game thread, which is the only thread unregistering listeners, 
+			// and not taken again when a listener of this thread broadcasts recursively.
+
+			static thread_local TArray<const UGameplayMessageSubsystem*, TInlineAllocator<2>> DispatchingSubsystems;
 
-			auto ListenerArray{ TArray<FGameplayMessageListenerData>(List->Listeners) };
+			const auto bTakeLock{ !IsInGameThread() && !DispatchingSubsystems.Contains(this) };
 
-			for (const auto& Listener : ListenerArray)
+			if (bTakeLock)
 			{
-				if (bOnInitialTag || (Listener.MatchType == EGameplayMessageMatch::PartialMatch))
+				ThreadSafeDispatchLock.ReadLock();
+				DispatchingSubsystems.Add(this);
+			}
+
+			ON_SCOPE_EXIT
+			{
+				if (bTakeLock)
 				{
-					if (Listener.bHadValidType && !Listener.ListenerStructType.IsValid())
-					{
-						UE_LOG(LogGameCore_Framework, Warning, TEXT("Listener struct type has gone invalid on Channel %s. Removing listener from list"), *Channel.ToString());
-						
-						UnregisterListenerInternal(Channel, Listener.HandleID);
+					DispatchingSubsystems.RemoveSingleSwap(this);
+					ThreadSafeDispatchLock.ReadUnlock();
+				}
+			};
 
-						continue;
-					}
+			for (const auto& Entry : *List)
+			{
+				// The listener may have been unregistered after the map was captured
+
+				if (Entry.Listener->bUnregistered)
+				{
+					continue;
+				}
+
+				if (!Entry.StructType || StructType->IsChildOf(Entry.StructType))
+				{
+					Entry.Listener->ReceivedCallback(Channel, StructType, MessageBytes);
+				}
+			}
+		}
+	}
+
+	// Drop the message if too many messages are waiting for the game thread
+
+	if ((MaxThreadSafeMessages > 0) && (NumThreadSafeMessages.fetch_add(1) >= MaxThreadSafeMessages))
+	{
+		--NumThreadSafeMessages;
+
+		INC_DWORD_STAT(STAT_GameplayMessage_NumThreadSafeDropped);
+
+		UE_LOG(LogGameCore_Framework, Warning, TEXT("Dropped thread-safe message on channel %s because %d messages are waiting for the game thread"), 
+			*Channel.ToString(), MaxThreadSafeMessages);
+
+		return;
+	}
+
+	// Queue a copy of the message for the other listeners to be delivered on the game thread
+
+	auto* Payload{ FMemory::Malloc(StructType->GetStructureSize(), FMath::Max(StructType->GetMinAlignment(), 1)) };
+	StructType->InitializeStruct(Payload);
+	StructType->CopyScriptStruct(Payload, MessageBytes);
+
+	FThreadSafeMessage Message;
+	Message.Channel = Channel;
+	Message.StructType = StructType;
+	Message.Payload = Payload;
+
+	ThreadSafeMessageQueue.Enqueue(Message);
+}
 
-					// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
+TSharedPtr<const UGameplayMessageSubsystem::FChannelDispatchList> UGameplayMessageSubsystem::FindOrBuildDispatchList(FGameplayTag Channel)
+{
+	if (const auto* CachedList{ DispatchMap.Find(Channel) })
+	{
+		return *CachedList;
+	}
+
+	INC_DWORD_STAT(STAT_GameplayMessage_NumDispatchListRebuilds);
+
+	// Collect the listeners of the channel and the PartialMatch listeners of its parents.
+	// Channels without listeners are not cached, so that the map only grows with channels that are listened to.
+
+	TSharedPtr<FChannelDispatchList> NewList;
+
+	auto bOnInitialTag{ true };
 
-					if (!Listener.bHadValidType || StructType->IsChildOf(Listener.ListenerStructType.Get()))
+	for (auto Tag{ Channel }; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+	{
+		if (const auto* List{ ListenerMap.Find(Tag) })
+		{
+			for (const auto& Listener : List->Listeners)
+			{
+				if (bOnInitialTag || (Listener->MatchType == EGameplayMessageMatch::PartialMatch))
+				{
+					if (!NewList.IsValid())
 					{
-						Listener.ReceivedCallback(Channel, StructType, MessageBytes);
+						NewList = MakeShared<FChannelDispatchList>();
 					}
-					else
+
+					NewList->Listeners.Add(Listener);
+					NewList->NumQueuedListeners += (Listener->DeliveryType == EGameplayMessageDelivery::Queued) ? 1 : 0;
+				}
+			}
+		}
+
+		bOnInitialTag = false;
+	}
+
+	if (!NewList.IsValid())
+	{
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_GameplayMessage_NumCachedDispatchLists);
+
+	return DispatchMap.Add(Channel, NewList);
+}
+
+void UGameplayMessageSubsystem::InvalidateDispatchLists(FGameplayTag Channel, EGameplayMessageMatch MatchType)
+{
+	if (DispatchMap.IsEmpty())
+	{
+		return;
+	}
+
+	if (DispatchMap.Remove(Channel) > 0)
+	{
+		DEC_DWORD_STAT(STAT_GameplayMessage_NumCachedDispatchLists);
+	}
+
+	// A PartialMatch listener is also dispatched from the child channels, so discard the ones that are cached
+
+	if (MatchType == EGameplayMessageMatch::PartialMatch)
+	{
+		const auto ChildChannels{ UGameplayTagsManager::Get().RequestGameplayTagChildren(Channel) };
+
+		for (const auto& ChildChannel : ChildChannels)
+		{
+			if (DispatchMap.Remove(ChildChannel) > 0)
+			{
+				DEC_DWORD_STAT(STAT_GameplayMessage_NumCachedDispatchLists);
+			}
+		}
+	}
+}
+
+bool UGameplayMessageSubsystem::InvokeListener(const FGameplayMessageListenerData& Listener, FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes)
+{
+	// The listener may have been unregistered after the dispatch list was captured
+
+	if (Listener.bUnregistered)
+	{
+		return false;
+	}
+
+	if (Listener.bHadValidType && !Listener.ListenerStructType.IsValid())
+	{
+		UE_LOG(LogGameCore_Framework, Warning, TEXT("Listener struct type has gone invalid on Channel %s. Removing listener from list"), *Channel.ToString());
+
+		if (Listener.bKeyed)
+		{
+			UnregisterKeyedListenerInternal(FMessageKey{ Listener.Channel, Listener.KeyObject, Listener.KeyTag }, Listener.HandleID);
+		}
+		else
+		{
+			UnregisterListenerInternal(Listener.Channel, Listener.HandleID);
+		}
+
+		return false;
+	}
+
+	// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
+
+	if (!Listener.bHadValidType || StructType->IsChildOf(Listener.ListenerStructType.Get()))
+	{
+		Listener.ReceivedCallback(Channel, StructType, MessageBytes);
+	}
+	else
+	{
+		UE_LOG(LogGameCore_Framework, Error, TEXT("Struct type mismatch on channel %s (broadcast type %s, listener at %s was expecting type %s)"),
+			*Channel.ToString(),
+			*StructType->GetPathName(),
+			*Listener.Channel.ToString(),
+			*Listener.ListenerStructType->GetPathName());
+	}
+
+	return true;
+}
+
+
+void UGameplayMessageSubsystem::ProcessThreadSafeMessages()
+{
+	check(IsInGameThread());
+
+	if (ThreadSafeMessageQueue.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GameplayMessage_ProcessThreadSafe);
+
+	// Drain only the messages that are queued now, so that messages broadcast by the listeners are delivered in the next tick.
+	// The messages are drained into a local array, so that listeners can call this again safely.
+
+	TArray<FThreadSafeMessage, TInlineAllocator<64>> DrainedMessages;
+
+	FThreadSafeMessage Message;
+	while (ThreadSafeMessageQueue.Dequeue(Message))
+	{
+		DrainedMessages.Add(Message);
+	}
+
+	NumThreadSafeMessages -= DrainedMessages.Num();
+
+	for (const auto& DrainedMessage : DrainedMessages)
+	{
+		BroadcastMessageInternal(DrainedMessage.Channel, DrainedMessage.StructType, DrainedMessage.Payload, /*bSkipAnyThreadListeners=*/ true);
+
+		DrainedMessage.StructType->DestroyStruct(DrainedMessage.Payload);
+		FMemory::Free(DrainedMessage.Payload);
+	}
+}
+
+void UGameplayMessageSubsystem::FlushQueuedMessages()
+{
+	if (bIsFlushingMessageQueue)
+	{
+		return;
+	}
+
+	auto& Queue{ MessageQueues[ActiveMessageQueueIndex] };
+
+	if (Queue.Messages.IsEmpty() && Queue.CoalescedMessages.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GameplayMessage_FlushQueue);
+
+	TGuardValue<bool> FlushGuard(bIsFlushingMessageQueue, true);
+
+	// Swap the queue so that messages broadcast while flushing are queued for the next flush
+
+	ActiveMessageQueueIndex = 1 - ActiveMessageQueueIndex;
+
+	// Deliver the latest coalesced messages to all listeners regardless of their delivery type
+
+	for (const auto& Message : Queue.CoalescedMessages)
+	{
+		if (Message.DispatchList.IsValid())
+		{
+			for (const auto& Listener : Message.DispatchList->Listeners)
+			{
+				InvokeListener(*Listener, Message.Channel, Message.StructType, Message.Payload);
+			}
+		}
+
+		InvokeKeyedListeners(Message.Channel, Message.KeyObject, Message.KeyTag, Message.StructType, Message.Payload);
+	}
+
+	// Deliver in broadcast order to the listeners captured when each message was broadcast.
+	// Consecutive messages sharing a dispatch list are delivered as a batch to each listener, which keeps the order seen by every listener.
+
+	const auto NumMessages{ Queue.Messages.Num() };
+
+	for (auto BatchStart{ 0 }, BatchEnd{ 0 }; BatchStart < NumMessages; BatchStart = BatchEnd)
+	{
+		const auto& DispatchList{ Queue.Messages[BatchStart].DispatchList };
+
+		for (BatchEnd = BatchStart + 1; (BatchEnd < NumMessages) && (Queue.Messages[BatchEnd].DispatchList == DispatchList); ++BatchEnd);
+
+		for (const auto& Listener : DispatchList->Listeners)
+		{
+			if (Listener->DeliveryType == EGameplayMessageDelivery::Queued)
+			{
+				for (auto Index{ BatchStart }; Index < BatchEnd; ++Index)
+				{
+					const auto& Message{ Queue.Messages[Index] };
+
+					if (!InvokeListener(*Listener, Message.Channel, Message.StructType, Message.Payload))
 					{
-						UE_LOG(LogGameCore_Framework, Error, TEXT("Struct type mismatch on channel %s (broadcast type %s, listener at %s was expecting type %s)"),
-							*Channel.ToString(),
-							*StructType->GetPathName(),
-							*Tag.ToString(),
-							*Listener.ListenerStructType->GetPathName());
+						break;
 					}
 				}
 			}
 		}
+	}
 
-		bOnInitialTag = false;
+	ResetMessageQueue(Queue);
+}
+
+void UGameplayMessageSubsystem::EnqueueMessage(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes, const TSharedPtr<const FChannelDispatchList>& DispatchList)
+{
+	INC_DWORD_STAT(STAT_GameplayMessage_NumQueuedMessages);
+
+	auto& Queue{ MessageQueues[ActiveMessageQueueIndex] };
+
+	// Copy the payload into the arena, which is reused every frame
+
+	auto* Payload{ Queue.PayloadArena.Alloc(StructType->GetStructureSize(), FMath::Max(StructType->GetMinAlignment(), 1)) };
+	StructType->InitializeStruct(Payload);
+	StructType->CopyScriptStruct(Payload, MessageBytes);
+
+	auto& Message{ Queue.Messages.AddDefaulted_GetRef() };
+	Message.Channel = Channel;
+	Message.StructType = StructType;
+	Message.Payload = Payload;
+	Message.DispatchList = DispatchList;
+}
+
+void UGameplayMessageSubsystem::BroadcastMessageCoalescedInternal(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, const UScriptStruct* StructType, const void* MessageBytes)
+{
+	auto& Queue{ MessageQueues[ActiveMessageQueueIndex] };
+
+	const auto Key{ FMessageKey{ Channel, FObjectKey(KeyObject), KeyTag } };
+
+	// Replace the payload of the message already queued with the same key
+
+	if (const auto* ExistingIndex{ Queue.CoalescedMessageIndices.Find(Key) })
+	{
+		auto& Message{ Queue.CoalescedMessages[*ExistingIndex] };
+
+		// The listeners are resolved again, since they are the ones of the latest broadcast
+
+		Message.DispatchList = FindOrBuildDispatchList(Channel);
+
+		if (Message.StructType == StructType)
+		{
+			INC_DWORD_STAT(STAT_GameplayMessage_NumCoalescedReplaced);
+
+			StructType->CopyScriptStruct(Message.Payload, MessageBytes);
+
+			return;
+		}
+
+		// Different struct type cannot reuse the payload, so replace the entry
+
+		Message.StructType->DestroyStruct(Message.Payload);
+
+		Message.StructType = StructType;
+		Message.Payload = Queue.PayloadArena.Alloc(StructType->GetStructureSize(), FMath::Max(StructType->GetMinAlignment(), 1));
+		StructType->InitializeStruct(Message.Payload);
+		StructType->CopyScriptStruct(Message.Payload, MessageBytes);
+
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_GameplayMessage_NumCoalescedMessages);
+
+	auto* Payload{ Queue.PayloadArena.Alloc(StructType->GetStructureSize(), FMath::Max(StructType->GetMinAlignment(), 1)) };
+	StructType->InitializeStruct(Payload);
+	StructType->CopyScriptStruct(Payload, MessageBytes);
+
+	Queue.CoalescedMessageIndices.Add(Key, Queue.CoalescedMessages.Num());
+
+	auto& Message{ Queue.CoalescedMessages.AddDefaulted_GetRef() };
+	Message.Channel = Channel;
+	Message.StructType = StructType;
+	Message.Payload = Payload;
+	Message.DispatchList = FindOrBuildDispatchList(Channel);
+	Message.KeyObject = Key.Object;
+	Message.KeyTag = KeyTag;
+}
+
+void UGameplayMessageSubsystem::ResetMessageQueue(FMessageQueue& Queue)
+{
+	for (const auto& Message : Queue.Messages)
+	{
+		Message.StructType->DestroyStruct(Message.Payload);
+	}
+
+	for (const auto& Message : Queue.CoalescedMessages)
+	{
+		Message.StructType->DestroyStruct(Message.Payload);
+	}
+
+	// Release the captured dispatch lists along with the messages
+
+	Queue.Messages.Reset();
+	Queue.CoalescedMessages.Reset();
+	Queue.CoalescedMessageIndices.Reset();
+	Queue.PayloadArena.Flush();
+}
+
+
+void UGameplayMessageSubsystem::RebuildThreadSafeListenerMap()
+{
+	auto NewMap{ MakeShared<FThreadSafeListenerMap>() };
+
+	for (const auto& KVP : ListenerMap)
+	{
+		for (const auto& Listener : KVP.Value.Listeners)
+		{
+			if (Listener->DeliveryType != EGameplayMessageDelivery::AnyThread)
+			{
+				continue;
+			}
+
+			// Resolve the message type here, so that other threads do not touch the weak pointer
+
+			const auto* StructType{ Listener->ListenerStructType.Get() };
+
+			if (Listener->bHadValidType && !StructType)
+			{
+				continue;
+			}
+
+			const auto Entry{ FThreadSafeListener{ Listener, StructType } };
+
+			NewMap->FindOrAdd(KVP.Key).Add(Entry);
+
+			// Flatten PartialMatch listeners into the child channels
+
+			if (Listener->MatchType == EGameplayMessageMatch::PartialMatch)
+			{
+				const auto ChildChannels{ UGameplayTagsManager::Get().RequestGameplayTagChildren(KVP.Key) };
+
+				for (const auto& ChildChannel : ChildChannels)
+				{
+					NewMap->FindOrAdd(ChildChannel).Add(Entry);
+				}
+			}
+		}
+	}
+
+	FWriteScopeLock WriteLock(ThreadSafeListenerMapLock);
+
+	if (NewMap->IsEmpty())
+	{
+		ThreadSafeListenerMap.Reset();
+	}
+	else
+	{
+		ThreadSafeListenerMap = NewMap;
+	}
+}
+
+
+void UGameplayMessageSubsystem::HandleWorldInitializedActors(const FActorsInitializedParams& Params)
+{
+	auto* World{ Params.World };
+
+	if (World && (World->GetGameInstance() == GetGameInstance()) && !FlushTickFunction.IsTickFunctionRegistered())
+	{
+		FlushTickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+void UGameplayMessageSubsystem::HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	if (World && (World->GetGameInstance() == GetGameInstance()) && FlushTickFunction.IsTickFunctionRegistered())
+	{
+		FlushQueuedMessages();
+
+		FlushTickFunction.UnRegisterTickFunction();
 	}
 }
 
@@ -193,3 +930,162 @@ bool UGameplayMessageSubsystem::HasInstance(const UObject* WorldContextObject)
 }
 
 #pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// Benchmark
+
+#pragma region Benchmark
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Allocator that forwards to the global allocator and counts the allocations made on the game thread
+ * 
+ * Tips:
+ *	Installed as GMalloc only while the benchmark broadcasts, so that the allocations per broadcast can be reported.
+ *	Kept alive after it is uninstalled, since another thread may still be calling it.
+ */
+class FGameplayMessageCountingMalloc final : public FMalloc
+{
+public:
+	FGameplayMessageCountingMalloc() {}
+
+	FMalloc* InnerMalloc{ nullptr };
+	std::atomic<uint64> NumAllocations{ 0 };
+
+public:
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override { CountAllocation(); return InnerMalloc->Malloc(Count, Alignment); }
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override { CountAllocation(); return InnerMalloc->TryMalloc(Count, Alignment); }
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override { CountAllocation(); return InnerMalloc->Realloc(Original, Count, Alignment); }
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override { CountAllocation(); return InnerMalloc->TryRealloc(Original, Count, Alignment); }
+	virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+
+protected:
+	void CountAllocation()
+	{
+		if (IsInGameThread())
+		{
+			NumAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+};
+
+static FAutoConsoleCommandWithWorldAndArgs CCmdGameplayMessageBenchmark(
+	TEXT("GameplayMessage.Benchmark"),
+	TEXT("Measures the cycles and allocations per broadcast on the TagStackCountChange channel against calling the listeners directly. Usage: GameplayMessage.Benchmark [NumListeners=256] [NumBroadcasts=10000]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World || !UGameplayMessageSubsystem::HasInstance(World))
+			{
+				UE_LOG(LogGameCore_Framework, Warning, TEXT("GameplayMessage.Benchmark: No GameplayMessageSubsystem found"));
+				return;
+			}
+
+			const auto NumListeners{ Args.IsValidIndex(0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 256 };
+			const auto NumBroadcasts{ Args.IsValidIndex(1) ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10000 };
+
+			auto& MessageSystem{ UGameplayMessageSubsystem::Get(World) };
+
+			// Register dummy listeners with captured state
+
+			auto NumReceived{ int64(0) };
+
+			const auto Callback
+			{
+				[&NumReceived](int32 Index, const FGameplayTagStackCountChangeMessage& Message)
+				{
+					NumReceived += (Message.Count + Index) > 0 ? 1 : 0;
+				}
+			};
+
+			TArray<FGameplayMessageListenerHandle> Handles;
+			Handles.Reserve(NumListeners);
+
+			for (auto Index{ 0 }; Index < NumListeners; ++Index)
+			{
+				Handles.Add(MessageSystem.RegisterListener<FGameplayTagStackCountChangeMessage>(TAG_Message_TagStackCountChange,
+					[&Callback, Index](FGameplayTag, const FGameplayTagStackCountChangeMessage& Message)
+					{
+						Callback(Index, Message);
+					}));
+			}
+
+			FGameplayTagStackCountChangeMessage Message;
+			Message.Tag = TAG_Stat;
+			Message.Count = 1;
+
+			// Warm up the dispatch list so that the measurement only covers the steady state
+
+			MessageSystem.BroadcastMessage(TAG_Message_TagStackCountChange, Message);
+
+			// Measure broadcasts
+
+			const auto BroadcastStartCycles{ FPlatformTime::Cycles64() };
+
+			for (auto Index{ 0 }; Index < NumBroadcasts; ++Index)
+			{
+				MessageSystem.BroadcastMessage(TAG_Message_TagStackCountChange, Message);
+			}
+
+			const auto BroadcastCycles{ FPlatformTime::Cycles64() - BroadcastStartCycles };
+
+			// Count the allocations of the same broadcasts separately, so that the counting does not affect the cycles
+
+			static FGameplayMessageCountingMalloc CountingMalloc;
+			CountingMalloc.InnerMalloc = GMalloc;
+			CountingMalloc.NumAllocations = 0;
+
+			GMalloc = &CountingMalloc;
+
+			for (auto Index{ 0 }; Index < NumBroadcasts; ++Index)
+			{
+				MessageSystem.BroadcastMessage(TAG_Message_TagStackCountChange, Message);
+			}
+
+			GMalloc = CountingMalloc.InnerMalloc;
+
+			const auto NumAllocations{ CountingMalloc.NumAllocations.load() };
+
+			// Measure the same callbacks called directly as the baseline
+
+			const auto DirectStartCycles{ FPlatformTime::Cycles64() };
+
+			for (auto Index{ 0 }; Index < NumBroadcasts; ++Index)
+			{
+				for (auto ListenerIndex{ 0 }; ListenerIndex < NumListeners; ++ListenerIndex)
+				{
+					Callback(ListenerIndex, Message);
+				}
+			}
+
+			const auto DirectCycles{ FPlatformTime::Cycles64() - DirectStartCycles };
+
+			for (auto& Handle : Handles)
+			{
+				Handle.Unregister();
+			}
+
+			const auto CyclesPerBroadcast{ double(BroadcastCycles) / NumBroadcasts };
+			const auto DirectCyclesPerBroadcast{ double(DirectCycles) / NumBroadcasts };
+
+			UE_LOG(LogGameCore_Framework, Log, TEXT("GameplayMessage.Benchmark: %d listeners, %d broadcasts, %lld callbacks, %.1f cycles/broadcast (%.3f us), %.1f cycles/broadcast when called directly, %.2f cycles overhead/listener, %.3f allocations/broadcast (%llu total)"),
+				NumListeners, NumBroadcasts, NumReceived,
+				CyclesPerBroadcast, FPlatformTime::ToMilliseconds64(BroadcastCycles) * 1000.0 / NumBroadcasts,
+				DirectCyclesPerBroadcast, (CyclesPerBroadcast - DirectCyclesPerBroadcast) / NumListeners,
+				double(NumAllocations) / NumBroadcasts, NumAllocations);
+		}));
+
+#endif
+
+#pragma endregion
@@ -3,6 +3,12 @@
 #pragma once
 
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Misc/MemStack.h"
+#include "Containers/Queue.h"
+#include "UObject/ObjectKey.h"
+
+#include <atomic>
 
 #include "Message/GameplayMessageTypes.h"
 
@@ -10,6 +16,8 @@
 
 #include "GameplayMessageSubsystem.generated.h"
 
+struct FActorsInitializedParams;
+
 
 /**
  * An opaque handle that can be used to remove a previously registered message listener
@@ -33,6 +41,15 @@ public:
 		, ID(InID) 
 	{}
 
+	FGameplayMessageListenerHandle(UGameplayMessageSubsystem* InSubsystem, FGameplayTag InChannel, FObjectKey InKeyObject, FGameplayTag InKeyTag, int32 InID)
+		: Subsystem(InSubsystem)
+		, Channel(InChannel)
+		, ID(InID)
+		, bKeyed(true)
+		, KeyObject(InKeyObject)
+		, KeyTag(InKeyTag)
+	{}
+
 private:
 	UPROPERTY(Transient)
 	TWeakObjectPtr<UGameplayMessageSubsystem> Subsystem;
@@ -43,6 +60,13 @@ private:
 	UPROPERTY(Transient)
 	int32 ID{ 0 };
 
+	//
+	// Key of the listener registered by RegisterKeyedListener
+	//
+	bool bKeyed{ false };
+	FObjectKey KeyObject;
+	FGameplayTag KeyTag;
+
 	FDelegateHandle StateClearedHandle;
 
 public:
@@ -78,7 +102,59 @@ public:
 
 	int32 HandleID;
 	EGameplayMessageMatch MatchType;
+	EGameplayMessageDelivery DeliveryType;
+
+	//
+	// Channel on which this listener was registered
+	//
+	FGameplayTag Channel;
+
+	//
+	// Object and tag on which this listener was registered (only for listeners registered by RegisterKeyedListener)
+	//
+	bool bKeyed{ false };
+	FObjectKey KeyObject;
+	FGameplayTag KeyTag;
+
+	//
+	// Set on the game thread when the listener is unregistered, so that dispatch lists captured earlier skip it
+	// (for AnyThread listeners, while holding the dispatch lock under which other threads read it)
+	//
+	mutable bool bUnregistered{ false };
+
+};
+
+
+/**
+ * Tick function that delivers the messages broadcast from other threads and 
+ * flushes the messages queued for listeners with Queued delivery
+ */
+USTRUCT()
+struct FGameplayMessageFlushTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+public:
+	FGameplayMessageFlushTickFunction() {}
+
+public:
+	//
+	// Subsystem whose message queue will be flushed
+	//
+	UGameplayMessageSubsystem* Target{ nullptr };
 
+public:
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FGameplayMessageFlushTickFunction> : public TStructOpsTypeTraitsBase2<FGameplayMessageFlushTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
 };
 
 
@@ -95,6 +171,19 @@ public:
  *
  * Note that call order when there are multiple listeners for the same channel is
  * not guaranteed and can change over time!
+ * 
+ * Listeners registered with Queued delivery receive copies of the messages in broadcast order,
+ * when the queue is flushed at the tick group set in UGameFrameworkDeveloperSettings.
+ * The listeners are resolved when the message is broadcast, and listeners unregistered before the flush are skipped.
+ * 
+ * Listeners registered with RegisterKeyedListener only receive the messages broadcast with BroadcastMessageKeyed
+ * (or BroadcastMessageCoalesced) for their object and tag, so they are not called for unrelated owners.
+ * 
+ * Messages can be broadcast from any thread with BroadcastMessageThreadSafe. Listeners registered
+ * with AnyThread delivery are called inline on the broadcasting thread, and the others are called
+ * on the game thread when the tick function runs.
+ * Once UnregisterListener returns, an AnyThread listener is no longer called on any thread, 
+ * since it waits for the calls in progress on other threads.
  */
 UCLASS()
 class GFCORE_API UGameplayMessageSubsystem : public UGameInstanceSubsystem
@@ -107,6 +196,7 @@ public:
 	UGameplayMessageSubsystem() {}
 
 public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
 
 
@@ -116,16 +206,169 @@ protected:
 	 */
 	struct FChannelListenerList
 	{
-		TArray<FGameplayMessageListenerData> Listeners;
+		TArray<TSharedRef<const FGameplayMessageListenerData>> Listeners;
 		int32 HandleID = 0;
 	};
 
+	/**
+	 * Flattened list of listeners to be called for a concrete broadcast channel
+	 * 
+	 * Tips:
+	 *	Contains the listeners of the channel itself and the PartialMatch listeners of all its parent channels.
+	 *	The list is immutable once built and is shared with in-flight broadcasts, 
+	 *	so registrations or removals during callbacks only replace the cached list.
+	 */
+	struct FChannelDispatchList
+	{
+		TArray<TSharedRef<const FGameplayMessageListenerData>> Listeners;
+		int32 NumQueuedListeners = 0;
+	};
+
+	/**
+	 * Key identifying messages about the same object and tag on a channel
+	 * 
+	 * Tips:
+	 *	Used to replace coalesced messages and to find keyed listeners.
+	 */
+	struct FMessageKey
+	{
+		FGameplayTag Channel;
+		FObjectKey Object;
+		FGameplayTag Tag;
+
+		bool operator==(const FMessageKey& Other) const
+		{
+			return (Channel == Other.Channel) && (Object == Other.Object) && (Tag == Other.Tag);
+		}
+
+		friend uint32 GetTypeHash(const FMessageKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Channel), GetTypeHash(Key.Object)), GetTypeHash(Key.Tag));
+		}
+	};
+
+	/**
+	 * Copy of a message waiting to be delivered to listeners with Queued delivery
+	 */
+	struct FQueuedMessage
+	{
+		FGameplayTag Channel;
+		const UScriptStruct* StructType = nullptr;
+		void* Payload = nullptr;
+
+		// Listeners of the channel when the message was broadcast
+		TSharedPtr<const FChannelDispatchList> DispatchList;
+
+		// Object and tag of coalesced messages, used to deliver them to keyed listeners
+		FObjectKey KeyObject;
+		FGameplayTag KeyTag;
+	};
+
+	/**
+	 * Messages queued within a frame and the arena holding their payloads
+	 */
+	struct FMessageQueue
+	{
+		FMemStackBase PayloadArena;
+		TArray<FQueuedMessage> Messages;
+
+		TArray<FQueuedMessage> CoalescedMessages;
+		TMap<FMessageKey, int32> CoalescedMessageIndices;
+	};
+
+	/**
+	 * Copy of a message broadcast from another thread waiting to be delivered on the game thread
+	 */
+	struct FThreadSafeMessage
+	{
+		FGameplayTag Channel;
+		const UScriptStruct* StructType = nullptr;
+		void* Payload = nullptr;
+	};
+
+	/**
+	 * Listener with AnyThread delivery and its message type resolved on the game thread
+	 */
+	struct FThreadSafeListener
+	{
+		TSharedRef<const FGameplayMessageListenerData> Listener;
+		const UScriptStruct* StructType = nullptr;
+	};
+
+	/**
+	 * Listeners with AnyThread delivery for each channel they are dispatched from
+	 * 
+	 * Tips:
+	 *	PartialMatch listeners are also added to the child channels when the map is built on the game thread,
+	 *	so other threads only need a single lookup without touching the tag manager or weak pointers.
+	 */
+	using FThreadSafeListenerMap = TMap<FGameplayTag, TArray<FThreadSafeListener>>;
+
 protected:
 	//
 	// Listen data map for messages related to GameplayTag
 	//
 	TMap<FGameplayTag, FChannelListenerList> ListenerMap;
 
+	//
+	// Listeners registered for a specific object and/or tag on a channel
+	// 
+	// Tips:
+	//	Each list is immutable and replaced when a listener is added or removed, 
+	//	so that broadcasts can hold a reference to it instead of copying it.
+	//
+	TMap<FMessageKey, TSharedRef<const FChannelDispatchList>> KeyedListenerMap;
+	int32 KeyedListenerHandleID{ 0 };
+
+	//
+	// Cached dispatch list for each channel broadcast so far (channels without listeners are not cached)
+	//
+	TMap<FGameplayTag, TSharedPtr<const FChannelDispatchList>> DispatchMap;
+
+	//
+	// Double buffered message queue so that messages broadcast during a flush are delivered in the next flush
+	//
+	FMessageQueue MessageQueues[2];
+	int32 ActiveMessageQueueIndex{ 0 };
+	bool bIsFlushingMessageQueue{ false };
+
+	//
+	// Tick function that flushes the message queue once per frame in the world of this game instance
+	//
+	FGameplayMessageFlushTickFunction FlushTickFunction;
+
+	//
+	// Lock-free queue of messages broadcast from any thread and drained on the game thread
+	// 
+	// Tips:
+	//	The number of messages is bounded by MaxThreadSafeMessages of UGameFrameworkDeveloperSettings,
+	//	since the queue is not drained while no world of the game instance is ticking.
+	//
+	TQueue<FThreadSafeMessage, EQueueMode::Mpsc> ThreadSafeMessageQueue;
+	std::atomic<int32> NumThreadSafeMessages{ 0 };
+	int32 MaxThreadSafeMessages{ 0 };
+
+	//
+	// Number of threads currently broadcasting with BroadcastMessageThreadSafe, waited for in Deinitialize
+	//
+	std::atomic<int32> NumThreadSafeBroadcasters{ 0 };
+	std::atomic<bool> bAcceptThreadSafeMessages{ false };
+
+	//
+	// Immutable snapshot of the listeners with AnyThread delivery, replaced on the game thread when they change
+	//
+	TSharedPtr<const FThreadSafeListenerMap> ThreadSafeListenerMap;
+	FRWLock ThreadSafeListenerMapLock;
+
+	//
+	// Held for reading by other threads while they call listeners with AnyThread delivery, and for writing 
+	// while such a listener is unregistered, so that UnregisterListener returns only after the calls in progress
+	//
+	FRWLock ThreadSafeDispatchLock;
+
+	FDelegateHandle WorldInitializedActorsHandle;
+	FDelegateHandle WorldCleanupHandle;
+
 public:
 	/**
 	 * Broadcast a message on the specified channel
@@ -140,16 +383,75 @@ public:
 		BroadcastMessageInternal(Channel, StructType, &Message);
 	}
 
+	/**
+	 * Broadcast a message on the specified channel from any thread
+	 * 
+	 * Tips:
+	 *	Listeners with AnyThread delivery are called inline on the calling thread.
+	 *	The other listeners receive a copy of the message on the game thread in the next tick.
+	 * 
+	 * Note:
+	 *	Keep a pointer to the subsystem obtained on the game thread instead of calling Get() from other threads.
+	 *
+	 * @param Channel			The message channel to broadcast on
+	 * @param Message			The message to send (must be the same type of UScriptStruct expected by the listeners for this channel, otherwise an error will be logged)
+	 */
+	template <typename FMessageStructType>
+	void BroadcastMessageThreadSafe(FGameplayTag Channel, const FMessageStructType& Message)
+	{
+		const auto* StructType{ TBaseStructure<FMessageStructType>::Get() };
+		BroadcastMessageThreadSafeInternal(Channel, StructType, &Message);
+	}
+
+	/**
+	 * Broadcast a message on the specified channel once per frame, keeping only the latest message for each key
+	 * 
+	 * Tips:
+	 *	The message is delivered to all listeners of the channel when the message queue is flushed.
+	 *	Messages broadcast with the same channel, object and tag in the same frame replace the previous one.
+	 *
+	 * @param Channel			The message channel to broadcast on
+	 * @param KeyObject			Object used to identify messages to be coalesced (e.g. the owner of the changed value)
+	 * @param KeyTag			Tag used to identify messages to be coalesced (e.g. the tag of the changed value)
+	 * @param Message			The message to send (must be the same type of UScriptStruct expected by the listeners for this channel, otherwise an error will be logged)
+	 */
+	template <typename FMessageStructType>
+	void BroadcastMessageCoalesced(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, const FMessageStructType& Message)
+	{
+		const auto* StructType{ TBaseStructure<FMessageStructType>::Get() };
+		BroadcastMessageCoalescedInternal(Channel, KeyObject, KeyTag, StructType, &Message);
+	}
+
+	/**
+	 * Broadcast a message on the specified channel to the listeners of the channel and the keyed listeners of the object and tag
+	 * 
+	 * Tips:
+	 *	Keyed listeners of other objects or tags are not called, so this costs nothing for them.
+	 *
+	 * @param Channel			The message channel to broadcast on
+	 * @param KeyObject			Object the message is about (e.g. the owner of the changed value)
+	 * @param KeyTag			Tag the message is about (e.g. the tag of the changed value)
+	 * @param Message			The message to send (must be the same type of UScriptStruct expected by the listeners for this channel, otherwise an error will be logged)
+	 */
+	template <typename FMessageStructType>
+	void BroadcastMessageKeyed(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, const FMessageStructType& Message)
+	{
+		const auto* StructType{ TBaseStructure<FMessageStructType>::Get() };
+		BroadcastMessageKeyedInternal(Channel, KeyObject, KeyTag, StructType, &Message);
+	}
+
 	/**
 	 * Register to receive messages on a specified channel
 	 *
 	 * @param Channel			The message channel to listen to
 	 * @param Callback			Function to call with the message when someone broadcasts it (must be the same type of UScriptStruct provided by broadcasters for this channel, otherwise an error will be logged)
+	 * @param MatchType			The rule used for matching the channel with broadcasted messages
+	 * @param DeliveryType		Whether the callback is called immediately or in a batch when the message queue is flushed
 	 *
 	 * @return a handle that can be used to unregister this listener (either by calling Unregister() on the handle or calling UnregisterListener on the router)
 	 */
 	template <typename FMessageStructType>
-	FGameplayMessageListenerHandle RegisterListener(FGameplayTag Channel, TFunction<void(FGameplayTag, const FMessageStructType&)>&& Callback, EGameplayMessageMatch MatchType = EGameplayMessageMatch::ExactMatch)
+	FGameplayMessageListenerHandle RegisterListener(FGameplayTag Channel, TFunction<void(FGameplayTag, const FMessageStructType&)>&& Callback, EGameplayMessageMatch MatchType = EGameplayMessageMatch::ExactMatch, EGameplayMessageDelivery DeliveryType = EGameplayMessageDelivery::Immediate)
 	{
 		auto ThunkCallback
 		{
@@ -161,7 +463,7 @@ public:
 
 		const auto* StructType{ TBaseStructure<FMessageStructType>::Get() };
 
-		return RegisterListenerInternal(Channel, ThunkCallback, StructType, MatchType);
+		return RegisterListenerInternal(Channel, ThunkCallback, StructType, MatchType, DeliveryType);
 	}
 
 	/**
@@ -221,14 +523,44 @@ public:
 			};
 
 			const auto* StructType{ TBaseStructure<FMessageStructType>::Get() };
-			Handle = RegisterListenerInternal(Channel, ThunkCallback, StructType, Params.MatchType);
+			Handle = RegisterListenerInternal(Channel, ThunkCallback, StructType, Params.MatchType, Params.DeliveryType);
 		}
 
 		return Handle;
 	}
 
 	/**
-	 * Remove a message listener previously registered by RegisterListener
+	 * Register to receive only the messages about a specified object and/or tag on a specified channel
+	 * 
+	 * Tips:
+	 *	Only messages broadcast with BroadcastMessageKeyed or BroadcastMessageCoalesced are delivered (immediately or when coalesced messages are flushed).
+	 *	The channel must match exactly. A null object or an empty tag matches any object or any tag.
+	 *
+	 * @param Channel			The message channel to listen to
+	 * @param KeyObject			Object the messages must be about (or null for any object)
+	 * @param KeyTag			Tag the messages must be about (or empty for any tag)
+	 * @param Callback			Function to call with the message when someone broadcasts it
+	 *
+	 * @return a handle that can be used to unregister this listener (either by calling Unregister() on the handle or calling UnregisterListener on the router)
+	 */
+	template <typename FMessageStructType>
+	FGameplayMessageListenerHandle RegisterKeyedListener(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, TFunction<void(FGameplayTag, const FMessageStructType&)>&& Callback)
+	{
+		auto ThunkCallback
+		{
+			[InnerCallback = MoveTemp(Callback)](FGameplayTag ActualTag, const UScriptStruct* SenderStructType, const void* SenderPayload)
+			{
+				InnerCallback(ActualTag, *reinterpret_cast<const FMessageStructType*>(SenderPayload));
+			}
+		};
+
+		const auto* StructType{ TBaseStructure<FMessageStructType>::Get() };
+
+		return RegisterKeyedListenerInternal(Channel, KeyObject, KeyTag, ThunkCallback, StructType);
+	}
+
+	/**
+	 * Remove a message listener previously registered by RegisterListener or RegisterKeyedListener
 	 *
 	 * @param Handle	The handle returned by RegisterListener
 	 */
@@ -240,6 +572,21 @@ private:
 	 */
 	void UnregisterListenerInternal(FGameplayTag Channel, int32 HandleID);
 
+	/**
+	 * Internal helper for unregistering a keyed message listener
+	 */
+	void UnregisterKeyedListenerInternal(const FMessageKey& Key, int32 HandleID);
+
+	/**
+	 * Internal helper for registering a keyed message listener
+	 */
+	FGameplayMessageListenerHandle RegisterKeyedListenerInternal(
+		FGameplayTag Channel,
+		const UObject* KeyObject,
+		FGameplayTag KeyTag,
+		TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback,
+		const UScriptStruct* StructType);
+
 	/**
 	 * Internal helper for registering a message listener
 	 */
@@ -247,7 +594,8 @@ private:
 		FGameplayTag Channel,
 		TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback,
 		const UScriptStruct* StructType,
-		EGameplayMessageMatch MatchType);
+		EGameplayMessageMatch MatchType,
+		EGameplayMessageDelivery DeliveryType = EGameplayMessageDelivery::Immediate);
 
 	
 protected:
@@ -266,7 +614,86 @@ private:
 	/**
 	 * Internal helper for broadcasting a message
 	 */
-	void BroadcastMessageInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes);
+	void BroadcastMessageInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes, bool bSkipAnyThreadListeners = false);
+
+	/**
+	 * Internal helper for broadcasting a message from any thread
+	 */
+	void BroadcastMessageThreadSafeInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes);
+
+	/**
+	 * Internal helper for broadcasting a keyed message
+	 */
+	void BroadcastMessageKeyedInternal(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, const UScriptStruct* StructType, const void* MessageBytes);
+
+	/**
+	 * Call the keyed listeners of the object and tag (including the ones registered for any object or any tag)
+	 */
+	void InvokeKeyedListeners(FGameplayTag Channel, FObjectKey KeyObject, FGameplayTag KeyTag, const UScriptStruct* StructType, const void* MessageBytes);
+
+	/**
+	 * Internal helper for broadcasting a coalesced message
+	 */
+	void BroadcastMessageCoalescedInternal(FGameplayTag Channel, const UObject* KeyObject, FGameplayTag KeyTag, const UScriptStruct* StructType, const void* MessageBytes);
+
+	/**
+	 * Returns the cached dispatch list for the channel, building it if it has not been cached yet
+	 * 
+	 * Tips:
+	 *	Returns null if there are no listeners for the channel.
+	 */
+	TSharedPtr<const FChannelDispatchList> FindOrBuildDispatchList(FGameplayTag Channel);
+
+	/**
+	 * Discard the cached dispatch list of the channel, and those of its child channels if the changed listener is PartialMatch
+	 */
+	void InvalidateDispatchLists(FGameplayTag Channel, EGameplayMessageMatch MatchType);
+
+	/**
+	 * Call the listener with the message if the message type is compatible
+	 * 
+	 * @return false if the listener has gone invalid and was removed
+	 */
+	bool InvokeListener(const FGameplayMessageListenerData& Listener, FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes);
+
+
+public:
+	/**
+	 * Deliver the messages broadcast from other threads to the game thread listeners
+	 * 
+	 * Tips:
+	 *	This is called automatically once per frame before FlushQueuedMessages.
+	 */
+	void ProcessThreadSafeMessages();
+
+	/**
+	 * Deliver all coalesced messages to the listeners of their channels, 
+	 * then all queued messages to the listeners with Queued delivery in broadcast order
+	 * 
+	 * Tips:
+	 *	This is called automatically once per frame, but can be called manually to deliver messages earlier.
+	 *	Messages broadcast while flushing are delivered in the next flush.
+	 */
+	void FlushQueuedMessages();
+
+private:
+	/**
+	 * Copy the message into the active message queue
+	 */
+	void EnqueueMessage(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes, const TSharedPtr<const FChannelDispatchList>& DispatchList);
+
+	/**
+	 * Destroy the payloads of the queued messages and reset the queue
+	 */
+	void ResetMessageQueue(FMessageQueue& Queue);
+
+	/**
+	 * Publish a new snapshot of the listeners with AnyThread delivery
+	 */
+	void RebuildThreadSafeListenerMap();
+
+	void HandleWorldInitializedActors(const FActorsInitializedParams& Params);
+	void HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
 
 	
 public:
@@ -1,4 +1,4 @@
-// Copyright (C) 2024 owoDra
+﻿// Copyright (C) 2024 owoDra
 
 #pragma once
 
@@ -28,6 +28,28 @@ enum class EGameplayMessageMatch : uint8
 };
 
 
+/**
+ * Delivery rule for message listeners
+ */
+UENUM(BlueprintType)
+enum class EGameplayMessageDelivery : uint8
+{
+	// The listener is called synchronously inside the broadcaster's stack frame
+	Immediate,
+
+	// The listener is called later, when the message queue is flushed, with messages delivered in broadcast order
+	// (e.g., once per frame at the QueuedMessageTickGroup set in the developer settings)
+	Queued,
+
+	// The listener is thread-safe and is called synchronously on whichever thread broadcasts the message
+	// (e.g., inline on a worker thread calling BroadcastMessageThreadSafe, or on the game thread for BroadcastMessage)
+	// UnregisterListener waits for the calls in progress on other threads, so the listener is never called after it returns.
+	// The listener must therefore not wait for the game thread, and must not be unregistered from another thread.
+	AnyThread
+
+};
+
+
 /**
  * Struct used to specify advanced behavior when registering a listener for gameplay messages
  */
@@ -40,6 +62,11 @@ public:
 	//
 	EGameplayMessageMatch MatchType{ EGameplayMessageMatch::ExactMatch };
 
+	//
+	// Whether Callback should be called synchronously when a message is broadcast or in a batch when the message queue is flushed.
+	//
+	EGameplayMessageDelivery DeliveryType{ EGameplayMessageDelivery::Immediate };
+
 	//
 	// If bound this callback will trigger when a message is broadcast on the specified channel.
 	//
@@ -3,6 +3,7 @@
 #include "GFCPlayerController.h"
 
 #include "Player/GFCLocalPlayer.h"
+#include "Player/PlayerTickBatchSubsystem.h"
 
 #include "Components/ControllerComponent.h"
 #include "Components/GameFrameworkComponentManager.h"
@@ -62,12 +63,12 @@ void AGFCPlayerController::ReceivedPlayer()
 
 	// Notify to Controller Components
 
-	TArray<UControllerComponent*> GFCComponents;
-	GetComponents(GFCComponents);
-	for (const auto& Component : GFCComponents)
-	{
-		Component->ReceivedPlayer();
-	}
+	ControllerComponents.ForEach(this,
+		[](UControllerComponent* Component)
+		{
+			Component->ReceivedPlayer();
+		}
+	);
 
 	// Notify to Local Player
 
@@ -116,10 +117,24 @@ void AGFCPlayerController::PlayerTick(float DeltaTime)
 {
 	Super::PlayerTick(DeltaTime);
 
-	TArray<UControllerComponent*> GFCComponents;
-	GetComponents(GFCComponents);
-	for (const auto& Component : GFCComponents)
+	// Let the subsystem tick the components of all players together if batching is enabled
+
+	if (auto* BatchSubsystem{ GetWorld()->GetSubsystem<UPlayerTickBatchSubsystem>() })
+	{
+		ControllerComponents.ForEach(this,
+			[BatchSubsystem, DeltaTime](UControllerComponent* Component)
+			{
+				BatchSubsystem->QueuePlayerTick(Component, DeltaTime);
+			}
+		);
+	}
+	else
 	{
-		Component->PlayerTick(DeltaTime);
+		ControllerComponents.ForEach(this,
+			[DeltaTime](UControllerComponent* Component)
+			{
+				Component->PlayerTick(DeltaTime);
+			}
+		);
 	}
 }
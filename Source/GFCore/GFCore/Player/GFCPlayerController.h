@@ -4,8 +4,12 @@
 
 #include "GameFramework/PlayerController.h"
 
+#include "Component/GFCComponentRegistry.h"
+
 #include "GFCPlayerController.generated.h"
 
+class UControllerComponent;
+
 
 /** 
  * Minimal class that supports extension by game feature plugins 
@@ -36,4 +40,12 @@ public:
 	virtual void OnUnPossess() override;
 	virtual void PlayerTick(float DeltaTime) override;
 
+protected:
+	//
+	// Controller components notified of the player events
+	//
+	TGFCComponentRegistry<UControllerComponent> ControllerComponents;
+
+	friend class UGFCControllerComponent;
+
 };
@@ -2,12 +2,132 @@
 
 #include "GFCPlayerState.h"
 
+#include "Component/GFCPlayerStateComponent.h"
+#include "GameFrameworkDeveloperSettings.h"
+#include "GFCoreLogs.h"
+
 #include "Components/GameFrameworkComponentManager.h"
 #include "Components/PlayerStateComponent.h"
+#include "Containers/Ticker.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GFCPlayerState)
 
 
+DECLARE_CYCLE_STAT(TEXT("Transfer Component Properties"), STAT_GFCPlayerState_TransferComponentProperties, STATGROUP_Game);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Transferred Player States"), STAT_GFCPlayerState_NumTransferredPlayerStates, STATGROUP_Game);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Transferred Player State Components"), STAT_GFCPlayerState_NumTransferredComponents, STATGROUP_Game);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Player State Component Mapping Builds"), STAT_GFCPlayerState_NumMappingBuilds, STATGROUP_Game);
+
+
+/**
+ * Names and classes of the player state components of a source and a target player state, sorted by name
+ * 
+ * Tips:
+ *	Player states with the same components have the same signature regardless of the order of their components,
+ *	so the pairs are built once for all players instead of once per player.
+ */
+struct FPlayerStateComponentSignature
+{
+public:
+	using FEntry = TPair<FName, TObjectKey<UClass>>;
+
+	TArray<FEntry, TInlineAllocator<8>> Sources;
+	TArray<FEntry, TInlineAllocator<8>> Targets;
+
+public:
+	FPlayerStateComponentSignature(TConstArrayView<UPlayerStateComponent*> InSources, TConstArrayView<UPlayerStateComponent*> InTargets)
+	{
+		Sources.Reserve(InSources.Num());
+		Targets.Reserve(InTargets.Num());
+
+		for (const auto* Source : InSources)
+		{
+			Sources.Emplace(Source->GetFName(), Source->GetClass());
+		}
+
+		for (const auto* Target : InTargets)
+		{
+			Targets.Emplace(Target->GetFName(), Target->GetClass());
+		}
+	}
+
+	bool operator==(const FPlayerStateComponentSignature& Other) const
+	{
+		return (Sources == Other.Sources) && (Targets == Other.Targets);
+	}
+
+	friend uint32 GetTypeHash(const FPlayerStateComponentSignature& Signature)
+	{
+		auto Hash{ GetTypeHash(Signature.Sources.Num()) };
+
+		for (const auto& Entry : Signature.Sources)
+		{
+			Hash = HashCombineFast(Hash, HashCombineFast(GetTypeHash(Entry.Key), GetTypeHash(Entry.Value)));
+		}
+
+		for (const auto& Entry : Signature.Targets)
+		{
+			Hash = HashCombineFast(Hash, HashCombineFast(GetTypeHash(Entry.Key), GetTypeHash(Entry.Value)));
+		}
+
+		return Hash;
+	}
+};
+
+/**
+ * Pairs of indices into the sorted source and target components of a signature
+ */
+using FPlayerStateComponentPairs = TArray<TPair<int32, int32>, TInlineAllocator<8>>;
+
+static FPlayerStateComponentPairs BuildPlayerStateComponentPairs(TConstArrayView<UPlayerStateComponent*> Sources, TConstArrayView<UPlayerStateComponent*> Targets)
+{
+	INC_DWORD_STAT(STAT_GFCPlayerState_NumMappingBuilds);
+
+	FPlayerStateComponentPairs Pairs;
+
+	for (auto SourceIndex{ 0 }; SourceIndex < Sources.Num(); ++SourceIndex)
+	{
+		const auto TargetIndex
+		{
+			Targets.IndexOfByPredicate(
+				[Source = Sources[SourceIndex]](const UPlayerStateComponent* Target)
+				{
+					// The target component may be a subclass of the source, since the properties of the source class are transferred
+
+					return (Target->GetFName() == Source->GetFName()) && Target->IsA(Source->GetClass());
+				}
+			)
+		};
+
+		if (TargetIndex != INDEX_NONE)
+		{
+			Pairs.Emplace(SourceIndex, TargetIndex);
+		}
+	}
+
+	return Pairs;
+}
+
+//
+// Component pairs by signature
+//
+static TMap<FPlayerStateComponentSignature, FPlayerStateComponentPairs> PlayerStateComponentMappings;
+
+/**
+ * Totals of the player states transferred in the current frame, logged once all players of a travel have been transferred
+ */
+struct FPlayerStateTransferSummary
+{
+	int32 NumPlayerStates{ 0 };
+	int32 NumComponents{ 0 };
+	int32 NumMappingBuilds{ 0 };
+	uint64 Cycles{ 0 };
+	bool bMove{ false };
+};
+
+static FPlayerStateTransferSummary PlayerStateTransferSummary;
+
+
 void AGFCPlayerState::PreInitializeComponents()
 {
 	Super::PreInitializeComponents();
@@ -33,26 +153,131 @@ void AGFCPlayerState::Reset()
 {
 	Super::Reset();
 
-	TArray<UPlayerStateComponent*> GFCComponents;
-	GetComponents(GFCComponents);
-	for (const auto& Component : GFCComponents)
-	{
-		Component->Reset();
-	}
+	PlayerStateComponents.ForEach(this,
+		[](UPlayerStateComponent* Component)
+		{
+			Component->Reset();
+		}
+	);
 }
 
 
+void AGFCPlayerState::SeamlessTravelTo(APlayerState* NewPlayerState)
+{
+	// This player state is destroyed after the transfer
+
+	TGuardValue<bool> SeamlessTravelingGuard(bIsSeamlessTraveling, true);
+
+	Super::SeamlessTravelTo(NewPlayerState);
+}
+
 void AGFCPlayerState::CopyProperties(APlayerState* PlayerState)
 {
 	Super::CopyProperties(PlayerState);
 
-	TInlineComponentArray<UPlayerStateComponent*> PlayerStateComponents;
-	GetComponents(PlayerStateComponents);
-	for (const auto& SourcePSComp : PlayerStateComponents)
+	if (PlayerState)
+	{
+		TransferComponentProperties(PlayerState, bIsSeamlessTraveling && GetDefault<UGameFrameworkDeveloperSettings>()->bMovePlayerStateComponentProperties);
+	}
+}
+
+void AGFCPlayerState::TransferComponentProperties(APlayerState* TargetPlayerState, bool bMove)
+{
+	check(TargetPlayerState);
+
+	SCOPE_CYCLE_COUNTER(STAT_GFCPlayerState_TransferComponentProperties);
+
+	const auto StartCycles{ FPlatformTime::Cycles64() };
+
+	// Gather the components of both player states without allocating
+
+	TArray<UPlayerStateComponent*, TInlineAllocator<8>> Sources;
+	TArray<UPlayerStateComponent*, TInlineAllocator<8>> Targets;
+
+	PlayerStateComponents.ForEach(this,
+		[&Sources](UPlayerStateComponent* Component)
+		{
+			Sources.Add(Component);
+		}
+	);
+
+	TargetPlayerState->ForEachComponent<UPlayerStateComponent>(false,
+		[&Targets](UPlayerStateComponent* Component)
+		{
+			Targets.Add(Component);
+		}
+	);
+
+	// Sort by name, since the order of the owned components differs between player states with the same components
+
+	const auto ByName
 	{
-		if (auto* TargetComp = Cast<UPlayerStateComponent>(static_cast<UObject*>(FindObjectWithOuter(PlayerState, SourcePSComp->GetClass(), SourcePSComp->GetFName()))))
+		[](const UPlayerStateComponent& A, const UPlayerStateComponent& B)
 		{
-			SourcePSComp->CopyProperties(TargetComp);
+			return A.GetFName().FastLess(B.GetFName());
 		}
+	};
+
+	Sources.Sort(ByName);
+	Targets.Sort(ByName);
+
+	// Pair the components by name and class once for all player states with the same components
+
+	FPlayerStateComponentSignature Signature(Sources, Targets);
+
+	auto* Pairs{ PlayerStateComponentMappings.Find(Signature) };
+	const auto bBuiltMapping{ Pairs == nullptr };
+
+	if (bBuiltMapping)
+	{
+		Pairs = &PlayerStateComponentMappings.Add(MoveTemp(Signature), BuildPlayerStateComponentPairs(Sources, Targets));
+	}
+
+	for (const auto& Pair : *Pairs)
+	{
+		auto* Source{ Sources[Pair.Key] };
+		auto* Target{ Targets[Pair.Value] };
+
+		if (auto* GFCSource{ bMove ? Cast<UGFCPlayerStateComponent>(Source) : nullptr })
+		{
+			GFCSource->MoveProperties(Target);
+		}
+		else
+		{
+			Source->CopyProperties(Target);
+		}
+	}
+
+	INC_DWORD_STAT(STAT_GFCPlayerState_NumTransferredPlayerStates);
+	INC_DWORD_STAT_BY(STAT_GFCPlayerState_NumTransferredComponents, Pairs->Num());
+
+	// Log the totals once per frame, since all players of a travel are transferred in the same frame
+
+	auto& Summary{ PlayerStateTransferSummary };
+
+	if (Summary.NumPlayerStates == 0)
+	{
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+			[](float)
+			{
+				const auto& Summary{ PlayerStateTransferSummary };
+
+				UE_LOG(LogGameCore_Framework, Log, TEXT("TransferComponentProperties: %d player states, %d components %s in %.2fus (%.2fus/player state), %d mappings built"),
+					Summary.NumPlayerStates, Summary.NumComponents, Summary.bMove ? TEXT("moved") : TEXT("copied"),
+					FPlatformTime::ToMilliseconds64(Summary.Cycles) * 1000.0,
+					FPlatformTime::ToMilliseconds64(Summary.Cycles) * 1000.0 / FMath::Max(Summary.NumPlayerStates, 1),
+					Summary.NumMappingBuilds);
+
+				PlayerStateTransferSummary = FPlayerStateTransferSummary();
+
+				return false;
+			}
+		));
 	}
+
+	Summary.NumPlayerStates += 1;
+	Summary.NumComponents += Pairs->Num();
+	Summary.NumMappingBuilds += bBuiltMapping ? 1 : 0;
+	Summary.Cycles += FPlatformTime::Cycles64() - StartCycles;
+	Summary.bMove |= bMove;
 }
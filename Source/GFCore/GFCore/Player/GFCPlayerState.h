@@ -4,8 +4,12 @@
 
 #include "GameFramework/PlayerState.h"
 
+#include "Component/GFCComponentRegistry.h"
+
 #include "GFCPlayerState.generated.h"
 
+class UPlayerStateComponent;
+
 
 /** 
  * Minimal class that supports extension by game feature plugins 
@@ -20,8 +24,28 @@ public:
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Reset() override;
+	virtual void SeamlessTravelTo(APlayerState* NewPlayerState) override;
 
 protected:
 	virtual void CopyProperties(APlayerState* PlayerState);
 
+	/**
+	 * Transfer the properties of the player state components to the components with the same name and class on the target
+	 */
+	void TransferComponentProperties(APlayerState* TargetPlayerState, bool bMove);
+
+protected:
+	//
+	// Whether this player state is being transferred to the player state of the new level
+	//
+	bool bIsSeamlessTraveling{ false };
+
+protected:
+	//
+	// Player state components notified of the player state events
+	//
+	TGFCComponentRegistry<UPlayerStateComponent> PlayerStateComponents;
+
+	friend class UGFCPlayerStateComponent;
+
 };
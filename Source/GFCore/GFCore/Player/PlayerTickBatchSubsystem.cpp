@@ -0,0 +1,240 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "PlayerTickBatchSubsystem.h"
+
+#include "GameFrameworkDeveloperSettings.h"
+#include "GFCoreLogs.h"
+
+#include "Components/ControllerComponent.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(PlayerTickBatchSubsystem)
+
+
+DECLARE_STATS_GROUP(TEXT("PlayerTickBatch"), STATGROUP_PlayerTickBatch, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Tick Batches"), STAT_PlayerTickBatch_Tick, STATGROUP_PlayerTickBatch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Player Ticks"), STAT_PlayerTickBatch_NumTicks, STATGROUP_PlayerTickBatch);
+
+
+UParallelPlayerTickInterface::UParallelPlayerTickInterface(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// Subsystem
+
+#pragma region Subsystem
+
+bool UPlayerTickBatchSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && GetDefault<UGameFrameworkDeveloperSettings>()->bBatchControllerPlayerTick;
+}
+
+void UPlayerTickBatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bAllowParallel = GetDefault<UGameFrameworkDeveloperSettings>()->bAllowParallelPlayerTick;
+}
+
+void UPlayerTickBatchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_PlayerTickBatch_Tick);
+
+	bHasQueuedComponents = false;
+
+	// Index based since a PlayerTick may queue a component of a new class
+
+	for (auto Index{ 0 }; Index < Batches.Num(); ++Index)
+	{
+		if (!Batches[Index].QueuedTicks.IsEmpty())
+		{
+			TickBatch(Index);
+		}
+	}
+}
+
+TStatId UPlayerTickBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlayerTickBatchSubsystem, STATGROUP_Tickables);
+}
+
+bool UPlayerTickBatchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return (WorldType == EWorldType::Game) || (WorldType == EWorldType::PIE);
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////////////////////
+// Batches
+
+#pragma region Batches
+
+void UPlayerTickBatchSubsystem::QueuePlayerTick(UControllerComponent* Component, float DeltaTime)
+{
+	check(Component);
+
+	// Never carry the queues over to another frame
+
+	if (QueuedFrameCounter != GFrameCounter)
+	{
+		DiscardQueuedTicks();
+
+		QueuedFrameCounter = GFrameCounter;
+	}
+
+	auto* Class{ Component->GetClass() };
+	const auto* BatchIndex{ BatchIndices.Find(Class) };
+
+	if (!BatchIndex)
+	{
+		auto& NewBatch{ Batches.AddDefaulted_GetRef() };
+		NewBatch.Class = Class;
+		NewBatch.bParallel = bAllowParallel && Class->ImplementsInterface(UParallelPlayerTickInterface::StaticClass());
+
+#if STATS
+		NewBatch.StatId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_PlayerTickBatch>(Class->GetName());
+#endif
+
+		BatchIndex = &BatchIndices.Add(Class, Batches.Num() - 1);
+	}
+
+	Batches[*BatchIndex].QueuedTicks.Add({ Component, DeltaTime });
+
+	bHasQueuedComponents = true;
+}
+
+void UPlayerTickBatchSubsystem::TickBatch(int32 BatchIndex)
+{
+	// Take the queue first, since a PlayerTick may queue components again
+
+	auto QueuedTicks{ MoveTemp(Batches[BatchIndex].QueuedTicks) };
+	Batches[BatchIndex].QueuedTicks.Reset();
+
+	// Drop components destroyed since they were queued, and tick the rest in memory order
+
+	QueuedTicks.RemoveAllSwap(
+		[](const FQueuedPlayerTick& QueuedTick)
+		{
+			return !IsValid(QueuedTick.Component.Get());
+		}
+	);
+
+	QueuedTicks.Sort(
+		[](const FQueuedPlayerTick& A, const FQueuedPlayerTick& B)
+		{
+			return A.Component.Get() < B.Component.Get();
+		}
+	);
+
+	const auto StartCycles{ FPlatformTime::Cycles64() };
+
+	{
+#if STATS
+		FScopeCycleCounter CycleCounter(Batches[BatchIndex].StatId);
+#endif
+
+		if (Batches[BatchIndex].bParallel)
+		{
+			ParallelFor(QueuedTicks.Num(),
+				[&QueuedTicks](int32 Index)
+				{
+					QueuedTicks[Index].Component->PlayerTick(QueuedTicks[Index].DeltaTime);
+				}
+			);
+		}
+		else
+		{
+			for (const auto& QueuedTick : QueuedTicks)
+			{
+				QueuedTick.Component->PlayerTick(QueuedTick.DeltaTime);
+			}
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_PlayerTickBatch_NumTicks, QueuedTicks.Num());
+
+	// Get the batch after ticking, since a PlayerTick may add a batch and reallocate the array
+
+	auto& Batch{ Batches[BatchIndex] };
+
+	Batch.LastTimeMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	Batch.TotalTimeMs += Batch.LastTimeMs;
+	Batch.NumFrames += 1;
+	Batch.NumTicks += QueuedTicks.Num();
+
+	// Give the allocation back to the queue so that the next frame does not allocate
+
+	if (Batch.QueuedTicks.IsEmpty())
+	{
+		QueuedTicks.Reset();
+		Batch.QueuedTicks = MoveTemp(QueuedTicks);
+	}
+}
+
+void UPlayerTickBatchSubsystem::DiscardQueuedTicks()
+{
+	if (!bHasQueuedComponents)
+	{
+		return;
+	}
+
+	auto NumDiscarded{ 0 };
+
+	for (auto& Batch : Batches)
+	{
+		NumDiscarded += Batch.QueuedTicks.Num();
+
+		Batch.QueuedTicks.Reset();
+	}
+
+	bHasQueuedComponents = false;
+
+	if (NumDiscarded > 0)
+	{
+		UE_LOG(LogGameCore_Framework, Verbose, TEXT("PlayerTickBatchSubsystem: Discarded %d PlayerTicks queued in a previous frame"), NumDiscarded);
+	}
+}
+
+void UPlayerTickBatchSubsystem::DumpStats() const
+{
+	UE_LOG(LogGameCore_Framework, Log, TEXT("PlayerTick batches:"));
+
+	for (const auto& Batch : Batches)
+	{
+		UE_LOG(LogGameCore_Framework, Log, TEXT("  %s%s: Last: %.3fms, Avg: %.3fms/frame, %.2f components/frame"),
+			*GetNameSafe(Batch.Class.Get()),
+			Batch.bParallel ? TEXT(" (Parallel)") : TEXT(""),
+			Batch.LastTimeMs,
+			(Batch.NumFrames > 0) ? (Batch.TotalTimeMs / Batch.NumFrames) : 0.0,
+			(Batch.NumFrames > 0) ? (static_cast<double>(Batch.NumTicks) / Batch.NumFrames) : 0.0);
+	}
+}
+
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorld CCmdPlayerTickBatchDumpStats(
+	TEXT("PlayerTickBatch.DumpStats"),
+	TEXT("Logs the PlayerTick timing of each controller component class batched by UPlayerTickBatchSubsystem"),
+	FConsoleCommandWithWorldDelegate::CreateLambda(
+		[](UWorld* World)
+		{
+			if (const auto* Subsystem{ World ? World->GetSubsystem<UPlayerTickBatchSubsystem>() : nullptr })
+			{
+				Subsystem->DumpStats();
+			}
+		}));
+
+#endif
+
+#pragma endregion
@@ -0,0 +1,140 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/Interface.h"
+
+#include "PlayerTickBatchSubsystem.generated.h"
+
+class UControllerComponent;
+
+
+/**
+ * Interface for controller components whose PlayerTick is thread-safe
+ * 
+ * Tips:
+ *	Components of classes implementing this interface may be ticked in parallel by UPlayerTickBatchSubsystem
+ *	when bAllowParallelPlayerTick is enabled in UGameFrameworkDeveloperSettings.
+ */
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class GFCORE_API UParallelPlayerTickInterface : public UInterface
+{
+	GENERATED_BODY()
+public:
+	UParallelPlayerTickInterface(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+};
+
+class GFCORE_API IParallelPlayerTickInterface
+{
+	GENERATED_BODY()
+};
+
+
+/**
+ * Subsystem that ticks the PlayerTick of the controller components of all players together, one class at a time
+ * 
+ * Tips:
+ *	Only created if bBatchControllerPlayerTick is enabled in UGameFrameworkDeveloperSettings.
+ *	AGFCPlayerController queues its components during its PlayerTick and they are ticked after all actors have ticked.
+ */
+UCLASS()
+class GFCORE_API UPlayerTickBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	UPlayerTickBatchSubsystem() {}
+
+	///////////////////////////////////////////////////////////
+	// Subsystem
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bHasQueuedComponents; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+
+	///////////////////////////////////////////////////////////
+	// Batches
+protected:
+	/**
+	 * Component queued for PlayerTick in this frame
+	 */
+	struct FQueuedPlayerTick
+	{
+		TWeakObjectPtr<UControllerComponent> Component;
+		float DeltaTime{ 0.0f };
+	};
+
+	/**
+	 * Components of a class queued for PlayerTick and the timing of the class
+	 */
+	struct FPlayerTickBatch
+	{
+		TWeakObjectPtr<UClass> Class;
+		TArray<FQueuedPlayerTick> QueuedTicks;
+
+		bool bParallel{ false };
+
+		double LastTimeMs{ 0.0 };
+		double TotalTimeMs{ 0.0 };
+		uint64 NumFrames{ 0 };
+		uint64 NumTicks{ 0 };
+
+#if STATS
+		TStatId StatId;
+#endif
+	};
+
+	//
+	// Batches in the order their classes were first queued
+	//
+	TArray<FPlayerTickBatch> Batches;
+
+	//
+	// Index of the batch of each class
+	//
+	TMap<TObjectKey<UClass>, int32> BatchIndices;
+
+	//
+	// Whether the parallel tick is allowed for the classes implementing IParallelPlayerTickInterface
+	//
+	bool bAllowParallel{ false };
+
+	//
+	// Whether any component has been queued in this frame
+	//
+	bool bHasQueuedComponents{ false };
+
+	//
+	// Frame in which the components in the queues were queued
+	//
+	uint64 QueuedFrameCounter{ 0 };
+
+public:
+	/**
+	 * Queue the PlayerTick of the component for this frame
+	 */
+	void QueuePlayerTick(UControllerComponent* Component, float DeltaTime);
+
+	/**
+	 * Log the timing of each class
+	 */
+	void DumpStats() const;
+
+protected:
+	void TickBatch(int32 BatchIndex);
+
+	/**
+	 * Discard the components left in the queues by a frame in which the subsystem did not tick
+	 */
+	void DiscardQueuedTicks();
+
+};
@@ -0,0 +1,312 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "ActorPoolSubsystem.h"
+
+#include "InitState/InitStateComponent.h"
+#include "InitState/InitStateSubsystem.h"
+#include "GFCoreLogs.h"
+
+#include "Components/GameFrameworkComponentManager.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(ActorPoolSubsystem)
+
+
+bool UActorPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return (WorldType == EWorldType::Game) || (WorldType == EWorldType::PIE);
+}
+
+
+AActor* UActorPoolSubsystem::AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, EInitStatePoolReacquireMode Mode)
+{
+	if (!ActorClass)
+	{
+		return nullptr;
+	}
+
+	auto* Pool{ Pools.Find(ActorClass.Get()) };
+
+	// Skip actors destroyed while they were in the pool
+
+	AActor* Actor{ nullptr };
+
+	while (Pool && !Pool->IsEmpty() && !Actor)
+	{
+		const auto PooledActor{ Pool->Pop() };
+
+		PooledActors.Remove(PooledActor);
+
+		Actor = PooledActor.Get();
+
+		if (!Actor)
+		{
+			ReleasedControllers.Remove(PooledActor);
+		}
+	}
+
+	if (!Actor)
+	{
+		return SpawnPoolableActor(ActorClass, Transform);
+	}
+
+	Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+	Actor->SetActorTickEnabled(Actor->PrimaryActorTick.bStartWithTickEnabled);
+
+	// Restart the init state chain of the features
+
+	TArray<IInitStatePoolableInterface*, TInlineAllocator<8>> Features;
+	GetPoolableFeatures(Actor, Features);
+
+	for (auto* Feature : Features)
+	{
+		Feature->OnReacquiredFromPool(Mode);
+	}
+
+	RestoreController(Actor);
+
+	UGameFrameworkComponentManager::SendGameFrameworkComponentExtensionEvent(Actor, UGameFrameworkComponentManager::NAME_GameActorReady);
+
+	return Actor;
+}
+
+void UActorPoolSubsystem::ReleaseActor(AActor* Actor)
+{
+	if (!IsValid(Actor) || (Actor->GetWorld() != GetWorld()))
+	{
+		return;
+	}
+
+	if (!ensureMsgf(!PooledActors.Contains(Actor), TEXT("[%s] has already been released to the pool."), *GetNameSafe(Actor)))
+	{
+		return;
+	}
+
+	// Unpossess instead of detaching the pawn as if it were destroyed, which would destroy AI controllers
+	// and make player controllers inactive. The controller is restored when the pawn is reacquired.
+
+	auto* Pawn{ Cast<APawn>(Actor) };
+	auto* Controller{ Pawn ? Pawn->GetController() : nullptr };
+
+	if (Controller && Pawn->HasAuthority())
+	{
+		ReleasedControllers.Add(Pawn, Controller);
+
+		Controller->UnPossess();
+	}
+
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+
+	// Let extension handlers undo what they did on NAME_GameActorReady, which is sent again on reacquire
+
+	UGameFrameworkComponentManager::SendGameFrameworkComponentExtensionEvent(Actor, UGameFrameworkComponentManager::NAME_ReceiverRemoved);
+	UGameFrameworkComponentManager::SendGameFrameworkComponentExtensionEvent(Actor, NAME_ActorReleasedToPool);
+
+	// Rewind the init state of the features
+
+	TArray<IInitStatePoolableInterface*, TInlineAllocator<8>> Features;
+	GetPoolableFeatures(Actor, Features);
+
+	for (auto* Feature : Features)
+	{
+		Feature->OnReleasedToPool();
+	}
+
+	// Drop the checks still pending from the last use (e.g. queued in BeginPlay when the evaluation is deferred),
+	// otherwise the rewound features would walk the chain again while the actor is in the pool
+
+	if (auto* InitStateSubsystem{ GetWorld()->GetSubsystem<UInitStateSubsystem>() })
+	{
+		InitStateSubsystem->CancelActor(Actor);
+	}
+
+	Pools.FindOrAdd(Actor->GetClass()).Add(Actor);
+	PooledActors.Add(Actor);
+}
+
+void UActorPoolSubsystem::PrewarmPool(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+	for (auto Index{ 0 }; Index < Count; ++Index)
+	{
+		ReleaseActor(SpawnPoolableActor(ActorClass, FTransform::Identity));
+	}
+}
+
+int32 UActorPoolSubsystem::GetNumPooledActors(TSubclassOf<AActor> ActorClass) const
+{
+	const auto* Pool{ Pools.Find(ActorClass.Get()) };
+
+	return Pool ? Pool->Num() : 0;
+}
+
+AActor* UActorPoolSubsystem::SpawnPoolableActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AActor>(ActorClass, Transform, SpawnParameters);
+}
+
+void UActorPoolSubsystem::RestoreController(AActor* Actor)
+{
+	TWeakObjectPtr<AController> ReleasedController;
+	ReleasedControllers.RemoveAndCopyValue(Actor, ReleasedController);
+
+	auto* Pawn{ Cast<APawn>(Actor) };
+
+	if (!Pawn || !Pawn->HasAuthority() || Pawn->GetController())
+	{
+		return;
+	}
+
+	// The previous controller may have been given another pawn while this one was in the pool
+
+	auto* Controller{ ReleasedController.Get() };
+
+	if (IsValid(Controller) && !Controller->GetPawn())
+	{
+		Controller->Possess(Pawn);
+	}
+	else if ((Pawn->AutoPossessAI == EAutoPossessAI::Spawned) || (Pawn->AutoPossessAI == EAutoPossessAI::PlacedInWorldOrSpawned))
+	{
+		Pawn->SpawnDefaultController();
+	}
+}
+
+void UActorPoolSubsystem::GetPoolableFeatures(AActor* Actor, TArray<IInitStatePoolableInterface*, TInlineAllocator<8>>& OutFeatures)
+{
+	Actor->ForEachComponent(false,
+		[&OutFeatures](UActorComponent* Component)
+		{
+			if (auto* Feature{ Cast<IInitStatePoolableInterface>(Component) })
+			{
+				// The InitState feature gates the other features, so it comes first
+
+				if (Component->IsA<UInitStateComponent>())
+				{
+					OutFeatures.Insert(Feature, 0);
+				}
+				else
+				{
+					OutFeatures.Add(Feature);
+				}
+			}
+		}
+	);
+}
+
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs CCmdActorPoolBenchmarkSpawn(
+	TEXT("ActorPool.BenchmarkSpawn"),
+	TEXT("Compares the cost of spawning and destroying actors with acquiring and releasing them through the pool, including the init state chain of their features. Usage: ActorPool.BenchmarkSpawn [ClassPath=/Script/GFCore.GFCPawn] [Count=100] [Restore=0]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+		{
+			auto* Subsystem{ World ? World->GetSubsystem<UActorPoolSubsystem>() : nullptr };
+
+			if (!Subsystem)
+			{
+				UE_LOG(LogGameCore_Framework, Warning, TEXT("ActorPool.BenchmarkSpawn: No pool in this world"));
+				return;
+			}
+
+			const auto ClassPath{ Args.IsValidIndex(0) ? Args[0] : FString(TEXT("/Script/GFCore.GFCPawn")) };
+			const auto Count{ Args.IsValidIndex(1) ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100 };
+			const auto Mode{ (Args.IsValidIndex(2) && FCString::ToBool(*Args[2])) ? EInitStatePoolReacquireMode::RestoreDataInitialized : EInitStatePoolReacquireMode::Replay };
+
+			TSubclassOf<AActor> ActorClass{ LoadClass<AActor>(nullptr, *ClassPath) };
+
+			if (!ActorClass)
+			{
+				UE_LOG(LogGameCore_Framework, Warning, TEXT("ActorPool.BenchmarkSpawn: Class [%s] not found"), *ClassPath);
+				return;
+			}
+
+			// Run the init state chain inside the measured regions even if its evaluation is deferred to the next tick
+
+			auto* InitStateSubsystem{ World->GetSubsystem<UInitStateSubsystem>() };
+
+			auto FlushInitState{
+				[InitStateSubsystem]()
+				{
+					const auto FlushStart{ FPlatformTime::Seconds() };
+
+					if (InitStateSubsystem)
+					{
+						InitStateSubsystem->FlushPendingActors();
+					}
+
+					return FPlatformTime::Seconds() - FlushStart;
+				}
+			};
+
+			TArray<AActor*> Actors;
+			Actors.Reserve(Count);
+
+			// Unpooled
+
+			const auto UnpooledStart{ FPlatformTime::Seconds() };
+
+			for (auto Index{ 0 }; Index < Count; ++Index)
+			{
+				FActorSpawnParameters SpawnParameters;
+				SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+				Actors.Add(World->SpawnActor<AActor>(ActorClass, FTransform::Identity, SpawnParameters));
+			}
+
+			const auto UnpooledFlushSeconds{ FlushInitState() };
+
+			for (auto* Actor : Actors)
+			{
+				if (Actor)
+				{
+					Actor->Destroy();
+				}
+			}
+
+			const auto UnpooledSeconds{ FPlatformTime::Seconds() - UnpooledStart };
+
+			// Pooled (the pool is filled beforehand so that no actor is spawned while measuring)
+
+			Subsystem->PrewarmPool(ActorClass, Count - Subsystem->GetNumPooledActors(ActorClass));
+			FlushInitState();
+
+			Actors.Reset();
+
+			const auto PooledStart{ FPlatformTime::Seconds() };
+
+			for (auto Index{ 0 }; Index < Count; ++Index)
+			{
+				Actors.Add(Subsystem->AcquireActor(ActorClass, FTransform::Identity, Mode));
+			}
+
+			const auto PooledFlushSeconds{ FlushInitState() };
+
+			for (auto* Actor : Actors)
+			{
+				Subsystem->ReleaseActor(Actor);
+			}
+
+			const auto PooledSeconds{ FPlatformTime::Seconds() - PooledStart };
+
+			UE_LOG(LogGameCore_Framework, Log, TEXT("ActorPool.BenchmarkSpawn: %d x [%s] Unpooled: %.2fus/actor (deferred init state chain %.2fus), Pooled (%s): %.2fus/actor (deferred init state chain %.2fus), Speedup: %.2fx"),
+				Count, *GetNameSafe(ActorClass),
+				(UnpooledSeconds * 1000000.0) / Count,
+				(UnpooledFlushSeconds * 1000000.0) / Count,
+				(Mode == EInitStatePoolReacquireMode::Replay) ? TEXT("Replay") : TEXT("RestoreDataInitialized"),
+				(PooledSeconds * 1000000.0) / Count,
+				(PooledFlushSeconds * 1000000.0) / Count,
+				(PooledSeconds > 0.0) ? (UnpooledSeconds / PooledSeconds) : 0.0);
+		}));
+
+#endif
@@ -0,0 +1,93 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "InitState/InitStatePoolableInterface.h"
+
+#include "ActorPoolSubsystem.generated.h"
+
+
+/**
+ * Subsystem that reuses actors instead of destroying and spawning them again
+ * 
+ * Tips:
+ *	Released actors are hidden and stay registered with the GameFrameworkComponentManager, 
+ *	and their features implementing IInitStatePoolableInterface rewind their init state.
+ *	Reacquired actors restart the init state chain of their features without re-creating any component.
+ *	Extension handlers receive NAME_ReceiverRemoved on release and NAME_GameActorReady again on reacquire.
+ *	Released pawns are unpossessed, and are possessed again by the same controller or their default AI controller on reacquire.
+ */
+UCLASS()
+class GFCORE_API UActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	UActorPoolSubsystem() {}
+
+	//
+	// Name of the event that signals that the actor has been released to the pool.
+	//
+	inline static const FName NAME_ActorReleasedToPool{ TEXTVIEW("ActorReleasedToPool") };
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+protected:
+	//
+	// Released actors by class
+	//
+	TMap<TWeakObjectPtr<UClass>, TArray<TWeakObjectPtr<AActor>>> Pools;
+
+	//
+	// All actors in the pools, to check whether an actor has already been released
+	//
+	TSet<TWeakObjectPtr<AActor>> PooledActors;
+
+	//
+	// Controllers that possessed the released pawns
+	//
+	TMap<TWeakObjectPtr<AActor>, TWeakObjectPtr<AController>> ReleasedControllers;
+
+public:
+	/**
+	 * Returns an actor of the class from the pool, or spawns a new one if the pool is empty
+	 */
+	AActor* AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, EInitStatePoolReacquireMode Mode = EInitStatePoolReacquireMode::Replay);
+
+	template<typename T>
+	T* AcquireActor(TSubclassOf<T> ActorClass, const FTransform& Transform, EInitStatePoolReacquireMode Mode = EInitStatePoolReacquireMode::Replay)
+	{
+		return Cast<T>(AcquireActor(TSubclassOf<AActor>(ActorClass), Transform, Mode));
+	}
+
+	/**
+	 * Return the actor to the pool of its class
+	 */
+	void ReleaseActor(AActor* Actor);
+
+	/**
+	 * Spawn actors of the class and release them to the pool
+	 */
+	void PrewarmPool(TSubclassOf<AActor> ActorClass, int32 Count);
+
+	/**
+	 * Returns the number of actors of the class waiting in the pool
+	 */
+	int32 GetNumPooledActors(TSubclassOf<AActor> ActorClass) const;
+
+protected:
+	AActor* SpawnPoolableActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform);
+
+	/**
+	 * Possess the reacquired pawn with the controller it had when released, or spawn its default controller as on spawn
+	 */
+	void RestoreController(AActor* Actor);
+
+	/**
+	 * Returns the poolable features of the actor with the InitState feature first
+	 */
+	static void GetPoolableFeatures(AActor* Actor, TArray<IInitStatePoolableInterface*, TInlineAllocator<8>>& OutFeatures);
+
+};
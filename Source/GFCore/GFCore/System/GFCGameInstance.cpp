@@ -2,7 +2,7 @@
 
 #include "GFCGameInstance.h"
 
-#include "InitState/InitStateTags.h"
+#include "InitState/InitStateTransitionTable.h"
 #include "GFCoreLogs.h"
 
 #include "Components/GameFrameworkComponentManager.h"
@@ -22,17 +22,11 @@ void UGFCGameInstance::Init()
 
 	auto* Subsystem{ GetSubsystem<UGameFrameworkComponentManager>() };
 
-	// @TODO: Allow changes from DeveloperSetting
+	// Compile the state chain from the developer settings for this session
 
-	static const TArray<FGameplayTag> StateChain
-	{
-		TAG_InitState_Spawned,
-		TAG_InitState_DataAvailable,
-		TAG_InitState_DataInitialized,
-		TAG_InitState_GameplayReady
-	};
+	FInitStateTransitionTable::Rebuild();
 
-	for (const auto& InitState : StateChain)
+	for (const auto& InitState : FInitStateTransitionTable::Get().GetStateChain())
 	{
 		Subsystem->RegisterInitState(InitState, false, FGameplayTag());
 	}